@@ -39,7 +39,7 @@ int main()
     //Całkowanie funkcji f(x) = x * cos^x
     const double a1 = 3.5, b1 = 6.52968912439344, STEP_N = 100;  // n dla metod klasycznych
     const int n = 100;
-    const double nG = 3, mG = 10;                    // Gauss: 3 węzły, 10 paneli, Możliwe są do wyboru także 2, 3 i 4 węzły
+    const double nG = 3, mG = 10;                    // Gauss: 3 węzły, 10 paneli, liczba węzłów może być dowolna (nG >= 1)
 
     std::cout << "Calka f(x)=x*cos^3(x) na [3.5, 6.52968912439344]\n";
     std::cout << "Midpoint            = "
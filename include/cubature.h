@@ -0,0 +1,42 @@
+﻿#pragma once
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+// Całki wielowymiarowe po prostopadłościanie [lo_1,hi_1] x ... x [lo_d,hi_d].
+
+namespace numlab {
+
+    using Vector = std::vector<double>;
+
+    using IntegrandND = std::function<double(const Vector& x)>;
+
+    struct CubatureResult {
+        double    value = 0.0;
+        double    error = 0.0;        // oszacowanie błędu (opis przy każdej metodzie)
+        long long evaluations = 0;
+    };
+
+    // Iloczyn tensorowy reguł Gaussa-Legendre'a, nG węzłów w każdym wymiarze
+    // (nG^d wywołań). Błąd = |Q(nG) - Q(nG-1)|, co kosztuje dodatkowo (nG-1)^d wywołań.
+    CubatureResult cubature_gauss(const IntegrandND& f,
+        const Vector& lo, const Vector& hi,
+        int nG = 5, int threads = 1);
+
+    // Siatka rzadka Smolyaka (technika kombinacji) z jednowymiarowych reguł
+    // Gaussa z l węzłami na poziomie l; level = 0 to jeden punkt.
+    // Dokładna dla wielomianów stopnia 2*level+1. Błąd = |A(level) - A(level-1)|.
+    CubatureResult cubature_sparse_grid(const IntegrandND& f,
+        const Vector& lo, const Vector& hi,
+        int level);
+
+    // Quasi-Monte Carlo na ciągu Sobola (d <= 16, kierunki Joe-Kuo), randomizowanym
+    // przez losowe przesunięcia cyfrowe. replicas niezależnych kopii po n punktów;
+    // wynik = średnia, błąd = odchylenie standardowe średniej. Wynik nie zależy
+    // od liczby wątków.
+    CubatureResult cubature_qmc(const IntegrandND& f,
+        const Vector& lo, const Vector& hi,
+        long long n, int replicas = 8, int threads = 0,
+        std::uint64_t seed = 12345);
+
+}
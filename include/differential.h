@@ -1,9 +1,15 @@
 ﻿#pragma once
 #include <vector>
 #include <functional>
+#include <limits>
+#include <cstddef>
+#include <iosfwd>
+#include <string>
 
 namespace numlab {
 
+    using Vector = std::vector<double>;
+
     struct StatePoint { double t, y; };
 
     using OdeRHS = std::function<double(double, double)>;
@@ -22,5 +28,187 @@ namespace numlab {
             const OdeRHS& f,
             const OdeStep& step = step_rk4);
 
-} 
+    // Metody adaptacyjne. Jawne pary Rungego-Kutty: rząd rozwiązania(rząd estymatora błędu);
+    // metody sztywne korzystają z macierzy Jacobiego (OdeOptions::jacobian lub różnice skończone)
+    // i jej rozkładu LU, używanych ponownie przez wiele kroków.
+    enum class OdeMethod {
+        DormandPrince45,      // 7 etapów, FSAL - 6 wywołań f na krok
+        CashKarp45,           // 6 etapów
+        BogackiShampine23,    // 4 etapy, FSAL - 3 wywołania f na krok (niskie tolerancje)
+        Rosenbrock23,         // sztywna: W-metoda Rosenbrocka 2(3) (Shampine), J odświeżane rzadko
+        RadauIIA5,            // sztywna: niejawna RK Radau IIA rzędu 5, uproszczony Newton
+        BDF                   // sztywna: BDF rzędu 1..5 ze zmiennym krokiem i rzędem
+    };
+
+    // J (n x n, wierszami): J[i*n + j] = d f_i / d y_j
+    using OdeJacobian = std::function<void(double t, const double* y, double* J)>;
+
+    // Zdarzenie: miejsce zerowe g(t, y) przecięte w trakcie kroku. Chwila przecięcia
+    // szukana metodą Brenta (root_brent) na gęstym wyjściu kroku, bez dodatkowych kroków.
+    struct OdeEvent {
+        std::function<double(double t, const double* y)> g;
+        int  direction = 0;       // 0 - oba kierunki, +1 tylko g: - -> +, -1 tylko g: + -> -
+        bool terminal = false;    // true - całkowanie kończy się w chwili zdarzenia
+    };
+
+    struct OdeEventHit {
+        int    event;             // indeks w OdeOptions::events
+        double t;
+        Vector y;
+    };
+
+    struct OdeOptions {
+        double      absTol = 1e-8;
+        double      relTol = 1e-6;
+        double      h0 = 0.0;                                        // 0 -> dobierany automatycznie
+        double      hMin = 0.0;                                      // 0 -> ~16 eps |t|
+        double      hMax = std::numeric_limits<double>::infinity();
+        int         maxSteps = 100000;                               // próby kroku (przyjęte + odrzucone)
+        OdeMethod   method = OdeMethod::DormandPrince45;
+        OdeJacobian jacobian;                                        // puste -> różnice skończone (n wywołań f)
+        std::vector<OdeEvent> events;
+    };
+
+    struct OdeStats {
+        int  accepted = 0;
+        int  rejected = 0;
+        int  evaluations = 0;     // liczba wywołań f (także do różnicowego J)
+        int  jacobians = 0;       // liczba wyznaczeń J (metody sztywne)
+        int  factorizations = 0;  // liczba rozkładów LU (metody sztywne)
+        bool success = false;     // false: h < hMin albo wyczerpane maxSteps (trajektoria do miejsca przerwania)
+        bool terminated = false;  // zatrzymane przez zdarzenie terminalne (ostatni punkt = chwila zdarzenia)
+        std::vector<OdeEventHit> hits;   // wykryte zdarzenia w kolejności czasu
+    };
+
+    // Krok adaptacyjny: błąd lokalny err_i / (absTol + relTol*max|y_i|) w normie RMS <= 1,
+    // odrzucenie i powtórzenie kroku z mniejszym h, sterownik PI dla kolejnego h.
+    // Metodę (jawną lub sztywną) wybiera opt.method.
+    // Zwraca punkty po każdym przyjętym kroku (pierwszy t0, ostatni tEnd
+    // lub chwila zdarzenia terminalnego z opt.events; y zdarzeń: y[0]).
+    std::vector<StatePoint>
+        ode_solve(double y0,
+            double t0, double tEnd,
+            const OdeRHS& f,
+            const OdeOptions& opt,
+            OdeStats* stats = nullptr);
+
+    // ---- Układy równań y' = f(t, y), y w R^n ------------------------------------
+    // f zapisuje pochodną do bufora podanego przez wywołującego (bez alokacji).
+    using OdeSystemRHS = std::function<void(double t, const double* y, double* dydt)>;
+
+    // Pamięć robocza kroków jawnych: k1..k4 + stan pośredni, alokowana raz.
+    class OdeWorkspace {
+    public:
+        static constexpr int STAGES = 5;
+
+        OdeWorkspace() = default;
+        explicit OdeWorkspace(int n) { resize(n); }
+
+        void resize(int n) { n_ = n; buf_.assign(static_cast<std::size_t>(STAGES) * n, 0.0); }
+        int size() const { return n_; }
+        double* stage(int j) { return buf_.data() + static_cast<std::ptrdiff_t>(j) * n_; }
+
+    private:
+        int n_ = 0;
+        Vector buf_;
+    };
+
+    // Kroki dla układów: y (n elementów) nadpisywane w miejscu, ws.size() >= n.
+    void step_euler_sys(double* y, int n, double t, double h, const OdeSystemRHS& f, OdeWorkspace& ws);
+    void step_heun_sys(double* y, int n, double t, double h, const OdeSystemRHS& f, OdeWorkspace& ws);
+    void step_midpoint_sys(double* y, int n, double t, double h, const OdeSystemRHS& f, OdeWorkspace& ws);
+    void step_rk4_sys(double* y, int n, double t, double h, const OdeSystemRHS& f, OdeWorkspace& ws);
+
+    using OdeSystemStep = std::function<void(double*, int, double, double, const OdeSystemRHS&, OdeWorkspace&)>;
+
+    // Trajektoria układu w jednym buforze: stan i-tego punktu to y[i*dim .. i*dim+dim-1].
+    struct OdeTrajectory {
+        int    dim = 0;
+        Vector t;
+        Vector y;
 
+        std::size_t size() const { return t.size(); }
+        const double* state(std::size_t i) const { return y.data() + i * dim; }
+    };
+
+    // Stały krok h: bufor wyniku rezerwowany z góry, pętla bez alokacji.
+    OdeTrajectory
+        ode_solve_system(const Vector& y0,
+            double t0, double tEnd,
+            double h,
+            const OdeSystemRHS& f,
+            const OdeSystemStep& step = step_rk4_sys);
+
+    // Krok adaptacyjny (jak skalarne ode_solve z OdeOptions).
+    OdeTrajectory
+        ode_solve_system(const Vector& y0,
+            double t0, double tEnd,
+            const OdeSystemRHS& f,
+            const OdeOptions& opt,
+            OdeStats* stats = nullptr);
+
+    // ---- Wyjście strumieniowe (bez przechowywania trajektorii) -------------------
+    // Obserwator dostaje punkt wyjścia; bufor y ważny tylko na czas wywołania.
+    using OdeObserver = std::function<void(double t, const double* y, int n)>;
+
+    struct OdeOutput {
+        OdeObserver observer;
+        int         decimate = 1;     // pusta siatka: co decimate-ty przyjęty krok (+ zawsze t0 i tEnd)
+        Vector      grid;             // niepusta: tylko te chwile (niemalejąco, w [t0, tEnd])
+    };
+
+    // Krok adaptacyjny jak ode_solve_system, ale punkty trafiają od razu do out.observer,
+    // pamięć O(n) niezależnie od liczby kroków. Chwile siatki leżące wewnątrz kroku są
+    // liczone z gęstego wyjścia: rozszerzenie ciągłe rzędu 4 dla DormandPrince45,
+    // wielomian interpolacyjny BDF, Hermite sześcienny dla pozostałych metod.
+    // Zwraca stan w ostatnim osiągniętym t (tEnd albo chwila zdarzenia terminalnego).
+    Vector
+        ode_integrate(const Vector& y0,
+            double t0, double tEnd,
+            const OdeSystemRHS& f,
+            const OdeOptions& opt,
+            const OdeOutput& out,
+            OdeStats* stats = nullptr);
+
+    // Obserwatory zapisujące wiersze "t;y0;y1;..." (pełna precyzja double).
+    OdeObserver ode_csv_writer(std::ostream& os, char sep = ';');
+    OdeObserver ode_csv_file(const std::string& path, char sep = ';');   // std::runtime_error, gdy nie można otworzyć
+
+    // ---- Zespół trajektorii (wiele warunków początkowych / parametrów naraz) -------
+    // Stan bloku trajektorii w układzie SoA: składowa i trajektorii first+k leży pod
+    // y[i*stride + k], k < count. f liczy pochodne całego bloku jednym wywołaniem
+    // (pętla po k jest ciągła w pamięci - kompilator ją wektoryzuje).
+    using OdeEnsembleRHS = std::function<void(double t, const double* y, double* dydt,
+        int first, int count, int stride)>;
+
+    // Warunek zatrzymania trajektorii traj; składowe stanu: y[i*stride].
+    using OdeEnsembleStop = std::function<bool(int traj, double t, const double* y, int stride)>;
+
+    struct EnsembleOptions {
+        int             saveEvery = 1;    // zapis co saveEvery kroków (+ zawsze t0 i tEnd)
+        int             threads = 0;      // 0 = wszystkie rdzenie
+        OdeEnsembleStop stop;             // puste - wszystkie trajektorie do tEnd
+    };
+
+    // Wynik kolumnowy: y[(s*dim + i)*count + k] - składowa i trajektorii k w próbce s.
+    // Po zatrzymaniu trajektorii kolejne próbki powtarzają stan z chwili tStop[k].
+    struct EnsembleResult {
+        int    count = 0, dim = 0;
+        Vector t;                                  // czasy próbek (wspólne)
+        Vector y;
+        Vector tStop;                              // tEnd dla trajektorii niezatrzymanych
+        std::vector<unsigned char> stopped;
+
+        std::size_t samples() const { return t.size(); }
+        double at(std::size_t s, int i, int k) const { return y[(s * dim + i) * count + k]; }
+    };
+
+    // RK4 ze stałym krokiem h dla count trajektorii w jednym kroku czasowym (lockstep);
+    // bloki po 64 trajektorie rozdzielane między wątki. y0[i*count + k] - stan początkowy.
+    EnsembleResult
+        ode_solve_ensemble(int count, int dim, const Vector& y0,
+            double t0, double tEnd, double h,
+            const OdeEnsembleRHS& f,
+            const EnsembleOptions& opt = {});
+
+} 
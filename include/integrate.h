@@ -1,11 +1,375 @@
 ﻿#pragma once
 #include <vector>
 #include <functional>
+#include <stdexcept>
+#include <queue>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <type_traits>
+#include <cstddef>
+#include <utility>
 
 namespace numlab {
 
     using Vector = std::vector<double>;
 
+    namespace detail {
+
+        struct GaussRule { const double* x; const double* w; int n; };   // węzły/wagi na [-1,1]
+
+        GaussRule gauss_rule(int nG);   // dowolne nG >= 1, tablice w pamięci podręcznej; nG < 1 -> std::invalid_argument
+
+    }
+
+    struct QuadResult {
+        double value = 0.0;       // przybliżenie całki
+        double error = 0.0;       // oszacowanie błędu bezwzględnego
+        int    evaluations = 0;   // liczba wywołań f
+        int    intervals = 0;     // liczba podprzedziałów na końcu
+        bool   converged = false; // czy osiągnięto tolerancję przed wyczerpaniem budżetu
+    };
+
+    namespace detail {
+
+        // Gauss-Kronrod G7-K15 (QUADPACK qk15): węzły Kronroda w porządku malejącym,
+        // węzły o nieparzystych indeksach (1,3,5) oraz 0 należą też do reguły Gaussa.
+        constexpr double K15_X[8] = {
+            0.991455371120812639206854697526329, 0.949107912342758524526189684047851,
+            0.864864423359769072789712788640926, 0.741531185599394439863864773280788,
+            0.586087235467691130294144845693013, 0.405845151377397166906606412076961,
+            0.207784955007898467600689403773245, 0.0 };
+        constexpr double K15_W[8] = {
+            0.022935322010529224963732008058970, 0.063092092629978553290700663189204,
+            0.104790010322250183839876322541518, 0.140653259715525918745189590510238,
+            0.169004726639267902826583426598550, 0.190350578064785409913256402421014,
+            0.204432940075298892414161999234649, 0.209482141084727828012999174891714 };
+        constexpr double G7_W[4] = {
+            0.129484966168869693270611432679082, 0.279705391489276667901467771423780,
+            0.381830050505118944950369775488975, 0.417959183673469387755102040816327 };
+
+        struct QuadSegment {
+            double a, b, value, error;
+            bool operator<(const QuadSegment& o) const { return error < o.error; }
+        };
+
+        // jedna reguła K15 na [a,b] z oszacowaniem błędu jak w QUADPACK
+        template<class F>
+        QuadSegment kronrod15(F& f, double a, double b)
+        {
+            const double c = 0.5 * (a + b), h = 0.5 * (b - a);
+            double fv[15];
+            const double fc = f(c);
+            fv[7] = fc;
+            double resK = K15_W[7] * fc, resG = G7_W[3] * fc;
+            for (int j = 0; j < 7; ++j) {
+                const double dx = h * K15_X[j];
+                const double f1 = f(c - dx), f2 = f(c + dx);
+                fv[j] = f1; fv[14 - j] = f2;
+                resK += K15_W[j] * (f1 + f2);
+                if (j % 2) resG += G7_W[j / 2] * (f1 + f2);
+            }
+            const double mean = 0.5 * resK;
+            double resAsc = K15_W[7] * std::fabs(fc - mean);
+            for (int j = 0; j < 7; ++j)
+                resAsc += K15_W[j] * (std::fabs(fv[j] - mean) + std::fabs(fv[14 - j] - mean));
+
+            const double ah = std::fabs(h);
+            double err = std::fabs((resK - resG) * h);
+            resAsc *= ah;
+            if (resAsc != 0.0 && err != 0.0)
+                err = resAsc * std::min(1.0, std::pow(200.0 * err / resAsc, 1.5));
+            return { a, b, resK * h, err };
+        }
+
+    }
+
+    // Adaptacyjny Gauss-Kronrod G7-K15: zawsze dzielimy na pół przedział
+    // o największym błędzie (kolejka priorytetowa), aż
+    // błąd <= max(absTol, relTol*|I|) albo skończy się budżet maxEval wywołań f.
+    template<class F>
+    QuadResult integral_adaptive(F&& f, double a, double b,
+        double absTol = 1e-10, double relTol = 1e-10, int maxEval = 100000)
+    {
+        if (absTol <= 0.0 && relTol <= 0.0) throw std::invalid_argument("tolerancja <= 0");
+        if (maxEval < 15) throw std::invalid_argument("maxEval < 15");
+
+        QuadResult res;
+        if (a == b) { res.converged = true; return res; }
+
+        std::priority_queue<detail::QuadSegment> heap;
+        heap.push(detail::kronrod15(f, a, b));
+        res.evaluations = 15;
+        double total = heap.top().value, totalErr = heap.top().error;
+
+        while (totalErr > std::max(absTol, relTol * std::fabs(total))) {
+            if (res.evaluations + 30 > maxEval) break;
+            const detail::QuadSegment s = heap.top();
+            const double mid = 0.5 * (s.a + s.b);
+            if (!(std::fabs(s.b - s.a) > 4 * std::numeric_limits<double>::epsilon() * std::fabs(mid))) break;
+            heap.pop();
+            const detail::QuadSegment l = detail::kronrod15(f, s.a, mid);
+            const detail::QuadSegment r = detail::kronrod15(f, mid, s.b);
+            res.evaluations += 30;
+            total += l.value + r.value - s.value;
+            totalErr += l.error + r.error - s.error;
+            heap.push(l);
+            heap.push(r);
+        }
+
+        // sumy liczone od nowa, żeby nie kumulować błędu aktualizacji przyrostowych
+        res.value = res.error = 0.0;
+        res.intervals = static_cast<int>(heap.size());
+        for (; !heap.empty(); heap.pop()) {
+            res.value += heap.top().value;
+            res.error += heap.top().error;
+        }
+        res.converged = res.error <= std::max(absTol, relTol * std::fabs(res.value));
+        return res;
+    }
+
+    // Znacznik trybu równoległego: integral_simpson(f, a, b, n, Parallel{ 4 }).
+    // threads = 0 -> wszystkie rdzenie.
+    struct Parallel { int threads = 0; };
+
+    namespace detail {
+
+        constexpr int QUAD_BLOCK = 4096;      // węzły w jednym bloku sumowania
+
+        // body(b0, b1) dla bloków [b0, b1) rozdzielanych między wątki (pula w integrate.cpp)
+        void run_blocks(int nBlocks, int threads, const std::function<void(int, int)>& body);
+
+        // f obsługuje wywołanie wsadowe f(const double* x, double* y, size_t n)
+        template<class F>
+        constexpr bool is_batch_v = std::is_invocable_v<F&, const double*, double*, std::size_t>;
+
+        inline double pairwise_sum(const double* v, int n)
+        {
+            if (n <= 8) {
+                double s = 0.0;
+                for (int i = 0; i < n; ++i) s += v[i];
+                return s;
+            }
+            const int m = n / 2;
+            return pairwise_sum(v, m) + pairwise_sum(v + m, n - m);
+        }
+
+        // Σ weight(k) * f(a + (k + off) * h)  dla k = k0 .. k1-1.
+        // Podział na bloki nie zależy od liczby wątków: w bloku suma Kahana,
+        // wyniki bloków łączone parami w stałej kolejności - wynik jest
+        // bitowo powtarzalny dla dowolnej liczby wątków.
+        template<class F, class W>
+        double parallel_nodes(F& f, double a, double h, double off, int k0, int k1, W weight, int threads)
+        {
+            const int total = k1 - k0;
+            if (total <= 0) return 0.0;
+            const int nb = (total + QUAD_BLOCK - 1) / QUAD_BLOCK;
+            std::vector<double> partial(nb);
+
+            run_blocks(nb, threads, [&](int b0, int b1) {
+                std::vector<double> xs, ys;
+                if constexpr (is_batch_v<F>) { xs.resize(QUAD_BLOCK); ys.resize(QUAD_BLOCK); }
+                for (int blk = b0; blk < b1; ++blk) {
+                    const int s = k0 + blk * QUAD_BLOCK, e = std::min(s + QUAD_BLOCK, k1);
+                    double sum = 0.0, comp = 0.0;
+                    auto add = [&](double v) {
+                        const double y = v - comp, t = sum + y;
+                        comp = (t - sum) - y;
+                        sum = t;
+                    };
+                    if constexpr (is_batch_v<F>) {
+                        for (int k = s; k < e; ++k) xs[k - s] = a + (k + off) * h;
+                        f(static_cast<const double*>(xs.data()), ys.data(), static_cast<std::size_t>(e - s));
+                        for (int k = s; k < e; ++k) add(weight(k) * ys[k - s]);
+                    }
+                    else {
+                        for (int k = s; k < e; ++k) add(weight(k) * f(a + (k + off) * h));
+                    }
+                    partial[blk] = sum;
+                }
+            });
+            return pairwise_sum(partial.data(), nb);
+        }
+
+        constexpr int BATCH_CHUNK = 256;     // porcja węzłów dla f wsadowej (x i y mieszczą się w L1)
+
+        // init + Σ weight(k) * f(node(k)),  k = k0 .. k1-1, sumowane po kolei.
+        // Dla f wsadowej węzły są generowane porcjami i przekazywane jednym wywołaniem.
+        template<class F, class X, class W>
+        double sum_nodes(F& f, double init, int k0, int k1, X node, W weight)
+        {
+            double sum = init;
+            if constexpr (is_batch_v<F>) {
+                double xs[BATCH_CHUNK], ys[BATCH_CHUNK];
+                for (int s = k0; s < k1; s += BATCH_CHUNK) {
+                    const int e = std::min(s + BATCH_CHUNK, k1);
+                    for (int k = s; k < e; ++k) xs[k - s] = node(k);
+                    f(static_cast<const double*>(xs), ys, static_cast<std::size_t>(e - s));
+                    for (int k = s; k < e; ++k) sum += weight(k) * ys[k - s];
+                }
+            }
+            else {
+                for (int k = k0; k < k1; ++k)
+                    sum += weight(k) * f(node(k));
+            }
+            return sum;
+        }
+
+        template<class F>
+        double eval_point(F& f, double x)
+        {
+            if constexpr (is_batch_v<F>) {
+                double y;
+                f(static_cast<const double*>(&x), &y, std::size_t{ 1 });
+                return y;
+            }
+            else {
+                return f(x);
+            }
+        }
+
+    }
+
+    template<class F>
+    double integral_midpoint(F&& f, double a, double b, int n, Parallel par)
+    {
+        if (n <= 0) throw std::invalid_argument("n <= 0");
+        const double h = (b - a) / n;
+        return detail::parallel_nodes(f, a, h, 0.5, 0, n, [](int) { return 1.0; }, par.threads) * h;
+    }
+
+    template<class F>
+    double integral_trapezoid(F&& f, double a, double b, int n, Parallel par)
+    {
+        if (n <= 0) throw std::invalid_argument("n <= 0");
+        const double h = (b - a) / n;
+        const double ends = 0.5 * (detail::eval_point(f, a) + detail::eval_point(f, b));
+        return (ends + detail::parallel_nodes(f, a, h, 0.0, 1, n, [](int) { return 1.0; }, par.threads)) * h;
+    }
+
+    template<class F>
+    double integral_simpson(F&& f, double a, double b, int n, Parallel par)
+    {
+        if (n <= 0) throw std::invalid_argument("n <= 0");
+        if (n % 2) ++n;
+        const double h = (b - a) / n;
+        const double ends = detail::eval_point(f, a) + detail::eval_point(f, b);
+        const double inner = detail::parallel_nodes(f, a, h, 0.0, 1, n,
+            [](int k) { return (k % 2) ? 4.0 : 2.0; }, par.threads);
+        return (ends + inner) * h / 3.0;
+    }
+
+    // Wersje szablonowe: całka f jest wywoływana bezpośrednio (bez std::function),
+    // więc kompilator może ją rozwinąć w pętli kwadratury. f może być też
+    // wsadowa - f(const double* x, double* y, size_t n) - wtedy dostaje węzły porcjami.
+
+    using BatchIntegrand = std::function<void(const double*, double*, std::size_t)>;
+
+    template<class F>
+    double integral_midpoint(F&& f, double a, double b, int n)
+    {
+        if (n <= 0) throw std::invalid_argument("n <= 0");
+        double h = (b - a) / n;
+        double sum = detail::sum_nodes(f, 0.0, 0, n,
+            [=](int i) { return a + (i + 0.5) * h; }, [](int) { return 1.0; });
+        return sum * h;
+    }
+
+    template<class F>
+    double integral_trapezoid(F&& f, double a, double b, int n)
+    {
+        if (n <= 0) throw std::invalid_argument("n <= 0");
+        double h = (b - a) / n;
+        double sum = 0.5 * (detail::eval_point(f, a) + detail::eval_point(f, b));
+        sum = detail::sum_nodes(f, sum, 1, n,
+            [=](int i) { return a + i * h; }, [](int) { return 1.0; });
+        return sum * h;
+    }
+
+    template<class F>
+    double integral_simpson(F&& f, double a, double b, int n)
+    {
+        if (n <= 0) throw std::invalid_argument("n <= 0");
+        if (n % 2) ++n;
+        double h = (b - a) / n, sum = detail::eval_point(f, a) + detail::eval_point(f, b);
+        sum = detail::sum_nodes(f, sum, 1, n,
+            [=](int i) { return a + i * h; }, [](int i) { return i % 2 ? 4.0 : 2.0; });
+        return sum * h / 3.0;
+    }
+
+    template<class F>
+    double integral_gauss_legendre(F&& f, double a, double b, int nG = 3, int m = 1)
+    {
+        const detail::GaussRule g = detail::gauss_rule(nG);
+
+        if (m <= 0) throw std::invalid_argument("m <= 0");
+        double h = (b - a) / m;
+
+        // węzeł k = j*nG + i: i-ty węzeł Gaussa w j-tym panelu
+        double sum = detail::sum_nodes(f, 0.0, 0, m * g.n,
+            [=](int k) {
+                const int j = k / g.n, i = k % g.n;
+                double aj = a + j * h, bj = aj + h;
+                double mid = 0.5 * (aj + bj), half = 0.5 * (bj - aj);
+                return mid + half * g.x[i];
+            },
+            [=](int k) { return g.w[k % g.n]; });
+        return sum * (h / 2.0);
+    }
+
+    struct RombergResult {
+        double value = 0.0;          // R[k][k] z ostatniego wiersza
+        double error = 0.0;          // |R[k][k] - R[k-1][k-1]|
+        int    evaluations = 0;      // liczba wywołań f (2^k + 1)
+        bool   converged = false;
+        std::vector<Vector> tableau; // tableau[k][j], j = 0..k; kolumna 0 = trapezy z 2^k przedziałami
+    };
+
+    // Romberg: trapezy z podwajaniem liczby przedziałów + ekstrapolacja Richardsona.
+    // Kolejny poziom liczy f tylko w nowych środkach (poprzednie wartości są już
+    // zawarte w R[k-1][0]), więc 2^k przedziałów kosztuje łącznie 2^k + 1 wywołań.
+    // Kończy, gdy błąd <= max(absTol, relTol*|I|) (najwcześniej na poziomie 3) lub po maxLevel.
+    // maxLevel < 3 -> std::invalid_argument (takie wywołanie nigdy nie byłoby converged).
+    template<class F>
+    RombergResult integral_romberg(F&& f, double a, double b,
+        double absTol = 1e-10, double relTol = 1e-10, int maxLevel = 20)
+    {
+        constexpr int MIN_LEVEL = 3;      // chroni przed przypadkową zgodnością na rzadkiej siatce
+        if (absTol <= 0.0 && relTol <= 0.0) throw std::invalid_argument("tolerancja <= 0");
+        if (maxLevel < MIN_LEVEL || maxLevel > 30) throw std::invalid_argument("maxLevel poza [3,30]");
+
+        RombergResult res;
+        res.tableau.push_back({ 0.5 * (b - a) * (detail::eval_point(f, a) + detail::eval_point(f, b)) });
+        res.evaluations = 2;
+        res.value = res.tableau[0][0];
+        res.error = std::numeric_limits<double>::infinity();
+
+        for (int k = 1; k <= maxLevel; ++k) {
+            const int n = 1 << (k - 1);                   // nowe węzły: a + (2i+1)h
+            const double h = (b - a) / (2.0 * n);
+            const double mids = detail::sum_nodes(f, 0.0, 0, n,
+                [=](int i) { return a + (2 * i + 1) * h; }, [](int) { return 1.0; });
+            res.evaluations += n;
+
+            const Vector& prev = res.tableau[k - 1];
+            Vector row(k + 1);
+            row[0] = 0.5 * prev[0] + h * mids;
+            double p4 = 1.0;
+            for (int j = 1; j <= k; ++j) {
+                p4 *= 4.0;
+                row[j] = row[j - 1] + (row[j - 1] - prev[j - 1]) / (p4 - 1.0);
+            }
+            res.error = std::fabs(row[k] - prev[k - 1]);
+            res.value = row[k];
+            res.tableau.push_back(std::move(row));
+            if (k >= MIN_LEVEL && res.error <= std::max(absTol, relTol * std::fabs(res.value))) {
+                res.converged = true;
+                break;
+            }
+        }
+        return res;
+    }
+
     double integral_midpoint(const std::function<double(double)>& f,
         double a, double b, int n);
 
@@ -19,6 +383,14 @@ namespace numlab {
         double a, double b,
         int nG = 3, int m = 1);
 
+    QuadResult integral_adaptive(const std::function<double(double)>& f,
+        double a, double b,
+        double absTol = 1e-10, double relTol = 1e-10, int maxEval = 100000);
+
+    RombergResult integral_romberg(const std::function<double(double)>& f,
+        double a, double b,
+        double absTol = 1e-10, double relTol = 1e-10, int maxLevel = 20);
+
 
     double integral_poly_midpoint(const Vector& a, double l, double r, int n);
     double integral_poly_trapezoid(const Vector& a, double l, double r, int n);
@@ -26,5 +398,9 @@ namespace numlab {
     double integral_poly_gauss(const Vector& a, double l, double r,
         int nG = 3, int m = 1);
 
+    // Dokładnie: P(r) - P(l), P - funkcja pierwotna (koszt O(stopień), bez próbkowania).
+    // Wersje kwadraturowe powyżej zostają do porównań na zajęciach.
+    double integral_poly_exact(const Vector& a, double l, double r);
+
 } 
 
@@ -1,12 +1,131 @@
 #pragma once
 #include <vector>
-#include <stdexcept>   
+#include <cstddef>
+#include <stdexcept>
 
 namespace numlab {
 
 	using Vector = std::vector<double>;
 	using Matrix = std::vector<Vector>;
 
-	Vector gaussian_elimination(Matrix A, Vector b, bool verbose = false);
+	// Widok (bez własności danych) na blok macierzy w układzie wierszowym:
+	// element (i,j) leży pod adresem data()[i*stride() + j].
+	class MatrixView {
+	public:
+		MatrixView() = default;
+		MatrixView(double* data, int rows, int cols, int stride)
+			: data_(data), rows_(rows), cols_(cols), stride_(stride) {}
 
-} 
+		int rows()   const { return rows_; }
+		int cols()   const { return cols_; }
+		int stride() const { return stride_; }
+		double* data() const { return data_; }
+
+		double* row(int i) const { return data_ + static_cast<std::ptrdiff_t>(i) * stride_; }
+		double& operator()(int i, int j) const { return row(i)[j]; }
+
+		MatrixView block(int i0, int j0, int r, int c) const { return { row(i0) + j0, r, c, stride_ }; }
+
+	private:
+		double* data_ = nullptr;
+		int rows_ = 0, cols_ = 0, stride_ = 0;
+	};
+
+	class ConstMatrixView {
+	public:
+		ConstMatrixView() = default;
+		ConstMatrixView(const double* data, int rows, int cols, int stride)
+			: data_(data), rows_(rows), cols_(cols), stride_(stride) {}
+		ConstMatrixView(const MatrixView& v)
+			: data_(v.data()), rows_(v.rows()), cols_(v.cols()), stride_(v.stride()) {}
+
+		int rows()   const { return rows_; }
+		int cols()   const { return cols_; }
+		int stride() const { return stride_; }
+		const double* data() const { return data_; }
+
+		const double* row(int i) const { return data_ + static_cast<std::ptrdiff_t>(i) * stride_; }
+		double operator()(int i, int j) const { return row(i)[j]; }
+
+		ConstMatrixView block(int i0, int j0, int r, int c) const { return { row(i0) + j0, r, c, stride_ }; }
+
+	private:
+		const double* data_ = nullptr;
+		int rows_ = 0, cols_ = 0, stride_ = 0;
+	};
+
+	// Macierz gęsta w jednym ciągłym buforze (wierszami, stride == cols).
+	class DenseMatrix {
+	public:
+		DenseMatrix() = default;
+		DenseMatrix(int rows, int cols, double value = 0.0);
+		explicit DenseMatrix(const Matrix& M);          // z vector<vector<double>>
+		explicit DenseMatrix(ConstMatrixView v);        // głęboka kopia widoku
+
+		int rows()   const { return rows_; }
+		int cols()   const { return cols_; }
+		int stride() const { return cols_; }
+		double* data() { return data_.data(); }
+		const double* data() const { return data_.data(); }
+
+		double* row(int i) { return data_.data() + static_cast<std::ptrdiff_t>(i) * cols_; }
+		const double* row(int i) const { return data_.data() + static_cast<std::ptrdiff_t>(i) * cols_; }
+		double& operator()(int i, int j) { return row(i)[j]; }
+		double  operator()(int i, int j) const { return row(i)[j]; }
+
+		MatrixView view() { return { data(), rows_, cols_, cols_ }; }
+		ConstMatrixView view() const { return { data(), rows_, cols_, cols_ }; }
+		operator MatrixView() { return view(); }
+		operator ConstMatrixView() const { return view(); }
+
+		Matrix to_matrix() const;
+
+	private:
+		int rows_ = 0, cols_ = 0;
+		Vector data_;
+	};
+
+	Vector gaussian_elimination(ConstMatrixView A, Vector b, bool verbose = false);
+	Vector gaussian_elimination(const Matrix& A, Vector b, bool verbose = false);
+
+	// Rozkład PA = LU z częściowym wyborem elementu głównego, liczony blokowo
+	// (panel + aktualizacja podmacierzy) - koszt O(n^3) płacimy raz, a każde
+	// kolejne rozwiązanie dla nowej prawej strony kosztuje O(n^2).
+	// threads > 1 (lub 0 = wszystkie rdzenie) włącza równoległą aktualizację
+	// podmacierzy; wynik jest identyczny z wersją jednowątkową.
+	class LUFactorization {
+	public:
+		static constexpr int DEFAULT_BLOCK = 64;
+
+		LUFactorization() = default;
+		explicit LUFactorization(ConstMatrixView A, int blockSize = DEFAULT_BLOCK, int threads = 1);
+
+		void factor(ConstMatrixView A, int blockSize = DEFAULT_BLOCK, int threads = 1);   // to samo n -> bez alokacji
+
+		Vector solve(Vector b) const;
+		void solve_inplace(double* b) const;                // b (size() elementów) <- x, bez alokacji
+		DenseMatrix solve_many(ConstMatrixView B) const;   // kolumny B = prawe strony
+
+		bool factored() const { return n_ > 0; }
+		int size() const { return n_; }
+		const DenseMatrix& lu() const { return lu_; }              // L (bez jedynek) i U w jednej macierzy
+		const std::vector<int>& pivots() const { return piv_; }    // wiersz i zamieniony z piv[i]
+
+	private:
+		DenseMatrix lu_;
+		std::vector<int> piv_;
+		int n_ = 0;
+	};
+
+	// Wiele niezależnych małych układów n x n (np. 3..16) w jednym spakowanym buforze.
+	//   Packed:      A[s*n*n + i*n + j],    b[s*n + i]
+	//   Interleaved: A[(i*n + j)*count + s], b[i*count + s]   (SoA - wektoryzacja po układach)
+	// Rozwiązuje w miejscu (A zostaje zniszczone, b <- x), bez alokacji na układ.
+	// Układ osobliwy dostaje x = NaN oraz info[s] = 1; zwracana jest liczba takich układów.
+	enum class BatchLayout { Packed, Interleaved };
+
+	int solve_batched(int n, int count, double* A, double* b,
+		BatchLayout layout = BatchLayout::Interleaved,
+		int threads = 1, int* info = nullptr);
+
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include <utility>
+#include <stdexcept>
+
+// Układy liniowe o rozmiarze znanym w czasie kompilacji (typowo 2..8).
+// Dane leżą na stosie, wszystkie pętle są rozwijane przez szablony,
+// a rozwiązanie można policzyć nawet w constexpr.
+
+namespace numlab {
+
+	template<int N>
+	struct FixedVector {
+		static_assert(N >= 1, "N >= 1");
+		double v[N];
+
+		constexpr double& operator[](int i) { return v[i]; }
+		constexpr double  operator[](int i) const { return v[i]; }
+		static constexpr int size() { return N; }
+	};
+
+	template<int N>
+	struct FixedMatrix {
+		static_assert(N >= 1, "N >= 1");
+		double a[N][N];
+
+		constexpr double& operator()(int i, int j) { return a[i][j]; }
+		constexpr double  operator()(int i, int j) const { return a[i][j]; }
+		static constexpr int size() { return N; }
+	};
+
+	namespace detail {
+
+		template<int B, class F, int... I>
+		constexpr void unroll_seq(F&& f, std::integer_sequence<int, I...>)
+		{
+			(f(std::integral_constant<int, B + I>{}), ...);
+		}
+
+		// f(integral_constant<int, i>) dla i = B .. E-1
+		template<int B, int E, class F>
+		constexpr void unroll(F&& f)
+		{
+			if constexpr (E > B)
+				unroll_seq<B>(f, std::make_integer_sequence<int, E - B>{});
+		}
+
+		constexpr double cabs(double x) { return x < 0 ? -x : x; }
+
+	}
+
+	// Eliminacja Gaussa z częściowym wyborem elementu głównego, w pełni rozwinięta.
+	// Macierz osobliwa -> std::runtime_error (jak gaussian_elimination).
+	template<int N>
+	constexpr FixedVector<N> solve_fixed(FixedMatrix<N> A, FixedVector<N> b)
+	{
+		using detail::unroll;
+		FixedVector<N> invDiag{};
+		unroll<0, N>([&](auto kc) {
+			constexpr int k = decltype(kc)::value;
+
+			// wszystkie indeksy są stałymi czasu kompilacji - macierz może żyć w rejestrach
+			int p = k;
+			double best = detail::cabs(A.a[k][k]);
+			unroll<k + 1, N>([&](auto ic) {
+				constexpr int i = decltype(ic)::value;
+				if (detail::cabs(A.a[i][k]) > best) { best = detail::cabs(A.a[i][k]); p = i; }
+			});
+			if (best < 1e-12)
+				throw std::runtime_error("Macierz osobliwa — brak rozwiązania");
+			unroll<k + 1, N>([&](auto ic) {
+				constexpr int i = decltype(ic)::value;
+				const bool sw = (p == i);           // zamiana bez skoku (cmov / blend)
+				unroll<k, N>([&](auto jc) {
+					constexpr int j = decltype(jc)::value;
+					const double rk = A.a[k][j], ri = A.a[i][j];
+					A.a[k][j] = sw ? ri : rk;
+					A.a[i][j] = sw ? rk : ri;
+				});
+				const double bk = b.v[k], bi = b.v[i];
+				b.v[k] = sw ? bi : bk;
+				b.v[i] = sw ? bk : bi;
+			});
+
+			invDiag.v[k] = 1.0 / A.a[k][k];
+			unroll<k + 1, N>([&](auto ic) {
+				constexpr int i = decltype(ic)::value;
+				const double f = A.a[i][k] * invDiag.v[k];
+				unroll<k + 1, N>([&](auto jc) {
+					constexpr int j = decltype(jc)::value;
+					A.a[i][j] -= f * A.a[k][j];
+				});
+				b.v[i] -= f * b.v[k];
+			});
+		});
+
+		FixedVector<N> x{};
+		unroll<0, N>([&](auto rc) {
+			constexpr int i = N - 1 - decltype(rc)::value;
+			double s = b.v[i];
+			unroll<i + 1, N>([&](auto jc) {
+				constexpr int j = decltype(jc)::value;
+				s -= A.a[i][j] * x.v[j];
+			});
+			x.v[i] = s * invDiag.v[i];
+		});
+		return x;
+	}
+
+	template<int N>
+	constexpr FixedVector<N> operator*(const FixedMatrix<N>& A, const FixedVector<N>& x)
+	{
+		FixedVector<N> y{};
+		detail::unroll<0, N>([&](auto ic) {
+			constexpr int i = decltype(ic)::value;
+			double s = 0.0;
+			detail::unroll<0, N>([&](auto jc) { s += A.a[i][decltype(jc)::value] * x.v[decltype(jc)::value]; });
+			y.v[i] = s;
+		});
+		return y;
+	}
+
+}
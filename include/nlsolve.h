@@ -1,11 +1,30 @@
 ﻿#pragma once
 #include <vector>
 #include <functional>
+#include <cstddef>
+#include <limits>
+#include "linsolve.h"
 
 namespace numlab {
 
     struct IterData { int iter; double x; };
 
+    enum class RootStatus : unsigned char {
+        Converged,      // spełnione kryterium eps
+        MaxIter,        // wyczerpane maxIter - root to ostatnie przybliżenie
+        BadBracket,     // f(a)*f(b) > 0 lub wartość nieskończona na końcu przedziału - root = NaN
+        Stalled,        // zerowa pochodna / płaska sieczna - root to ostatnie przybliżenie
+        NotFinite       // iteracja dała NaN/Inf
+    };
+
+    // Wynik metod z przedziałem izolacji (root_brent, root_itp, root_illinois).
+    struct RootResult {
+        double     root = std::numeric_limits<double>::quiet_NaN();
+        int        iterations = 0;
+        int        evaluations = 0;       // łącznie z f(a), f(b)
+        RootStatus status = RootStatus::MaxIter;
+    };
+
     constexpr double NL_EPS = 1e-10;   
     constexpr int    NL_MAX_ITER = 100;     
 
@@ -34,5 +53,115 @@ namespace numlab {
         int    maxIter = NL_MAX_ITER,
         std::vector<IterData>* trace = nullptr);
 
-} 
+    // Metody z gwarancją przedziału izolacji (f(a)*f(b) <= 0) i zbieżnością nadliniową.
+    // eps - tolerancja położenia pierwiastka: kończą, gdy przedział ma szerokość <= 2*eps
+    // (Brent: |b-c|/2 <= eps/2 + 2*DBL_EPS*|b|) albo f(x) == 0. Zły przedział -> BadBracket, root = NaN.
+    // Brent (zeroin): interpolacja odwrotna kwadratowa / sieczna z zabezpieczeniem bisekcją.
+    RootResult root_brent(const std::function<double(double)>& f,
+        double a, double b,
+        double eps = NL_EPS,
+        int    maxIter = NL_MAX_ITER,
+        std::vector<IterData>* trace = nullptr);
+
+    // ITP (Interpolate-Truncate-Project, Oliveira-Takahashi): nie więcej iteracji
+    // niż bisekcja + 1, a dla gładkich f zbieżność rzędu ~1.6.
+    // eps jest podnoszone do max(eps, DBL_EPS*max(|a|,|b|), DBL_MIN) - eps <= 0 nie
+    // jest błędem, oznacza "do precyzji maszynowej".
+    RootResult root_itp(const std::function<double(double)>& f,
+        double a, double b,
+        double eps = NL_EPS,
+        int    maxIter = NL_MAX_ITER,
+        std::vector<IterData>* trace = nullptr);
+
+    // Regula falsi z modyfikacją Illinois: wartość na końcu, który drugi raz z rzędu
+    // się nie zmienia, jest połowiona - bez "zastygania" jednego końca dla f wypukłych.
+    // Dla pierwiastków wielokrotnych (f bardzo płaska) lepiej root_itp / root_brent.
+    RootResult root_illinois(const std::function<double(double)>& f,
+        double a, double b,
+        double eps = NL_EPS,
+        int    maxIter = NL_MAX_ITER,
+        std::vector<IterData>* trace = nullptr);
+
+    // ---- Wiele niezależnych równań naraz ---------------------------------------
+    // Równanie i ma własny przedział / punkt startowy. f liczy wartości dla porcji
+    // kolejnych równań: fx[k] = f_{first+k}(x[k]), k < count (ciągła pętla - wektoryzacja).
+    // Wszystkie równania porcji iterują razem, zbieżne są maskowane; porcje po 256
+    // równań rozdzielane między wątki (threads = 0 - wszystkie rdzenie).
+    using RootBatchFunction = std::function<void(const double* x, double* fx, int first, int count)>;
+    using RootBatchDerivative = std::function<void(const double* x, double* fx, double* dfx, int first, int count)>;
+
+    struct RootBatchResult {
+        std::vector<double>     root;
+        std::vector<int>        iterations;
+        std::vector<RootStatus> status;
+
+        std::size_t size() const { return root.size(); }
+        std::size_t converged() const;
+    };
+
+    // Kryteria stopu jak w wersjach skalarnych.
+    RootBatchResult root_bisection_batch(const RootBatchFunction& f,
+        const std::vector<double>& a, const std::vector<double>& b,
+        double eps = NL_EPS, int maxIter = NL_MAX_ITER, int threads = 0);
+
+    RootBatchResult root_regulafalsi_batch(const RootBatchFunction& f,
+        const std::vector<double>& a, const std::vector<double>& b,
+        double eps = NL_EPS, int maxIter = NL_MAX_ITER, int threads = 0);
+
+    RootBatchResult root_secant_batch(const RootBatchFunction& f,
+        const std::vector<double>& x0, const std::vector<double>& x1,
+        double eps = NL_EPS, int maxIter = NL_MAX_ITER, int threads = 0);
+
+    RootBatchResult root_newton_batch(const RootBatchDerivative& fdf,
+        const std::vector<double>& x0,
+        double eps = NL_EPS, int maxIter = NL_MAX_ITER, int threads = 0);
+
+    // ---- Układy równań nieliniowych F(x) = 0, x w R^n ---------------------------
+    // F zapisuje n wartości do bufora fx; J (n x n, wierszami): J[i*n + j] = dF_i / dx_j.
+    using SystemFunction = std::function<void(const double* x, double* fx)>;
+    using SystemJacobian = std::function<void(const double* x, double* J)>;
+
+    enum class SystemMethod {
+        Newton,         // nowe J i rozkład LU w każdej iteracji
+        Broyden         // J raz, potem aktualizacje rzędu 1 odwrotności (O(n^2) na iterację)
+    };
+
+    struct SystemOptions {
+        double         tol = 1e-10;         // ||F(x)||_inf <= tol
+        double         stepTol = 1e-14;     // ||dx||_inf <= stepTol*(1 + ||x||_inf) przy ||F|| > tol -> Stalled
+        int            maxIter = 100;
+        SystemMethod   method = SystemMethod::Newton;
+        SystemJacobian jacobian;            // puste -> różnice skończone (n wywołań F)
+        bool           lineSearch = true;   // nawrót (Armijo) na 0.5*||F||^2
+        int            threads = 1;         // rozkład LU (jak LUFactorization)
+    };
+
+    struct SystemResult {
+        int        iterations = 0;
+        int        evaluations = 0;         // wywołania F (także do różnicowego J)
+        int        jacobians = 0;           // wyznaczenia J (Broyden: tylko przy starcie / restarcie)
+        double     residual = 0.0;          // ||F(x)||_inf w zwróconym x
+        RootStatus status = RootStatus::MaxIter;   // Stalled: J osobliwe albo brak spadku residuum
+    };
+
+    // Pamięć robocza solvera układów - po pierwszym wywołaniu dla danego n
+    // kolejne wywołania nie alokują.
+    struct SystemWorkspace {
+        int             n = 0;
+        DenseMatrix     J;
+        DenseMatrix     H;                  // przybliżenie J^-1 (Broyden)
+        LUFactorization lu;
+        std::vector<double> buf;            // wektory robocze
+
+        SystemWorkspace() = default;
+        explicit SystemWorkspace(int size) { resize(size); }
+        void resize(int size);
+    };
+
+    // Newton / Broyden z przeszukiwaniem liniowym; x - punkt startowy, nadpisywany wynikiem.
+    // Broyden odświeża J, gdy kierunek z przybliżenia nie daje spadku residuum.
+    SystemResult root_system(const SystemFunction& F, std::vector<double>& x,
+        const SystemOptions& opt = {},
+        SystemWorkspace* ws = nullptr);
 
+}
@@ -0,0 +1,45 @@
+﻿#pragma once
+#include <vector>
+#include <cstddef>
+#include <complex>
+
+// Wielomiany p(x) = a[0] + a[1]*x + ... + a[n]*x^n  (współczynniki rosnąco,
+// tak samo jak w poly_horner i poly_lsq).
+
+namespace numlab {
+
+    using Vector = std::vector<double>;
+
+    // Schemat Estrina: potęgi x^2, x^4, ... i sumowanie parami - łańcuch zależności
+    // ma długość O(log n) zamiast O(n) jak w Hornerze (szybszy dla wysokich stopni).
+    double poly_estrin(const Vector& a, double x);
+
+    // y[i] = p(x[i]) dla wielu punktów naraz - Horner na rejestrach AVX2/AVX-512
+    // (wybór w czasie działania), kilka niezależnych łańcuchów FMA jednocześnie.
+    void   poly_eval_many(const Vector& a, const double* x, double* y, std::size_t n);
+    Vector poly_eval_many(const Vector& a, const Vector& x);
+
+    Vector poly_derivative(const Vector& a);                        // współczynniki p'
+    Vector poly_antiderivative(const Vector& a, double c0 = 0.0);   // współczynniki P, P' = p, P(0) = c0
+
+    // ---- Wszystkie pierwiastki (zespolone) -------------------------------------
+    // Metoda Aberth-Ehrlich: jednoczesna iteracja wszystkich przybliżeń, p/p' z Hornera
+    // (dla |z| > 1 na wielomianie odwróconym), stop gdy |p(z)| nie przekracza
+    // ograniczenia błędu zaokrągleń Hornera. Zbieżność sześcienna dla pierwiastków
+    // pojedynczych, liniowa dla wielokrotnych (dokładność ~ eps^(1/krotność)).
+    using Complex = std::complex<double>;
+    constexpr int POLY_ROOTS_MAX_ITER = 200;
+
+    // Pierwiastki posortowane wg (Re, Im); ich liczba = stopień po odcięciu zerowych
+    // najwyższych współczynników. Wielomian zerowy -> std::invalid_argument.
+    std::vector<Complex> poly_roots(const Vector& a, int maxIter = POLY_ROOTS_MAX_ITER,
+        bool* converged = nullptr);
+
+    // count wielomianów tego samego stopnia: a[s*(degree+1) + k], pierwiastki do
+    // roots[s*degree + j]. Wielomiany rozdzielane między wątki (0 = wszystkie rdzenie).
+    // Brak zbieżności lub wielomian zerowy -> info[s] = 1; zwraca liczbę takich wielomianów.
+    // Gdy a[s*(degree+1) + degree] == 0, brakujące pierwiastki ("w nieskończoności") = NaN.
+    int poly_roots_batch(int degree, int count, const double* a, Complex* roots,
+        int threads = 1, int* info = nullptr);
+
+}
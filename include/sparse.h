@@ -0,0 +1,64 @@
+﻿#pragma once
+#include <vector>
+#include "linsolve.h"
+
+namespace numlab {
+
+    struct Triplet { int row, col; double value; };
+
+    // Macierz rzadka w formacie CSR (Compressed Sparse Row). Indeksy kolumn
+    // w każdym wierszu są posortowane rosnąco, bez powtórzeń.
+    class CsrMatrix {
+    public:
+        CsrMatrix() = default;
+        CsrMatrix(int rows, int cols,
+            std::vector<int> rowPtr, std::vector<int> colIdx, Vector values);
+
+        // powtarzające się pozycje (i,j) są sumowane
+        static CsrMatrix from_triplets(int rows, int cols, std::vector<Triplet> t);
+        static CsrMatrix from_dense(ConstMatrixView A, double dropTol = 0.0);
+
+        int rows() const { return rows_; }
+        int cols() const { return cols_; }
+        int nnz()  const { return static_cast<int>(val_.size()); }
+        const std::vector<int>& row_ptr() const { return ptr_; }
+        const std::vector<int>& col_idx() const { return idx_; }
+        const Vector& values() const { return val_; }
+
+        void multiply(const double* x, double* y) const;       // y = A x
+        Vector operator*(const Vector& x) const;
+
+    private:
+        int rows_ = 0, cols_ = 0;
+        std::vector<int> ptr_{ 0 }, idx_;
+        Vector val_;
+    };
+
+    enum class Preconditioner { None, Jacobi, ILU0 };
+
+    struct IterativeOptions {
+        double tol = 1e-10;        // kryterium względne: ||r|| <= tol * ||b||
+        double absTol = 0.0;       // ... lub bezwzględne ||r|| <= absTol
+        int    maxIter = 1000;
+        int    restart = 30;       // tylko GMRES(m)
+        Preconditioner precond = Preconditioner::None;
+    };
+
+    struct IterativeResult {
+        Vector x;
+        int    iterations = 0;
+        double residual = 0.0;     // ||b - A x|| na końcu
+        bool   converged = false;
+    };
+
+    // x0 == nullptr -> start od zera
+    IterativeResult solve_cg(const CsrMatrix& A, const Vector& b,
+        const IterativeOptions& opt = {}, const Vector* x0 = nullptr);     // A symetryczna, dodatnio określona
+
+    IterativeResult solve_bicgstab(const CsrMatrix& A, const Vector& b,
+        const IterativeOptions& opt = {}, const Vector* x0 = nullptr);
+
+    IterativeResult solve_gmres(const CsrMatrix& A, const Vector& b,
+        const IterativeOptions& opt = {}, const Vector* x0 = nullptr);
+
+}
@@ -0,0 +1,255 @@
+﻿#include "cubature.h"
+#include "integrate.h"
+#include "parallel.h"
+#include <cmath>
+#include <limits>
+#include <random>
+#include <stdexcept>
+
+namespace {
+
+    using numlab::Vector;
+    using numlab::IntegrandND;
+    using numlab::detail::GaussRule;
+
+    constexpr int CUB_BLOCK = 4096;       // punkty w jednym bloku sumowania
+
+    int check_box(const Vector& lo, const Vector& hi)
+    {
+        if (lo.empty() || lo.size() != hi.size())
+            throw std::invalid_argument("Niepoprawne granice obszaru");
+        return static_cast<int>(lo.size());
+    }
+
+    // Σ w_i f(x_i) dla iloczynu tensorowego reguł r[0] x ... x r[d-1] (na [-1,1]^d),
+    // przeskalowane do [lo,hi]. Bloki o stałej długości i suma parami - wynik
+    // nie zależy od liczby wątków.
+    double tensor_rule(const IntegrandND& f, const Vector& lo, const Vector& hi,
+        const std::vector<GaussRule>& r, int threads, long long& evals)
+    {
+        const int d = static_cast<int>(lo.size());
+        Vector mid(d), half(d);
+        long long total = 1;
+        double jac = 1.0;
+        for (int i = 0; i < d; ++i) {
+            mid[i] = 0.5 * (lo[i] + hi[i]);
+            half[i] = 0.5 * (hi[i] - lo[i]);
+            jac *= half[i];
+            total *= r[i].n;
+        }
+        const long long nb = (total + CUB_BLOCK - 1) / CUB_BLOCK;
+        if (nb > std::numeric_limits<int>::max())
+            throw std::invalid_argument("Zbyt wiele punktów kubatury");
+        Vector part(static_cast<std::size_t>(nb));
+
+        numlab::detail::SharedPool pool(nb > 1 ? numlab::detail::resolve_threads(threads) : 1);
+        pool.parallel_for(0, static_cast<int>(nb), 1, [&](int b0, int b1) {
+            Vector x(d);
+            std::vector<int> idx(d);
+            for (int blk = b0; blk < b1; ++blk) {
+                const long long s = static_cast<long long>(blk) * CUB_BLOCK;
+                const long long e = std::min(s + CUB_BLOCK, total);
+                long long rem = s;                      // indeks mieszany, wymiar 0 najszybszy
+                for (int i = 0; i < d; ++i) { idx[i] = static_cast<int>(rem % r[i].n); rem /= r[i].n; }
+
+                double sum = 0.0;
+                for (long long k = s; k < e; ++k) {
+                    double w = 1.0;
+                    for (int i = 0; i < d; ++i) {
+                        x[i] = mid[i] + half[i] * r[i].x[idx[i]];
+                        w *= r[i].w[idx[i]];
+                    }
+                    sum += w * f(x);
+                    for (int i = 0; i < d && ++idx[i] == r[i].n; ++i)
+                        idx[i] = 0;
+                }
+                part[blk] = sum;
+            }
+        });
+        evals += total;
+        return numlab::detail::pairwise_sum(part.data(), static_cast<int>(nb)) * jac;
+    }
+
+    double smolyak(const IntegrandND& f, const Vector& lo, const Vector& hi,
+        int level, long long& evals)
+    {
+        const int d = static_cast<int>(lo.size());
+        const int q = d + level;
+        std::vector<int> l(d, 1);
+        std::vector<GaussRule> rules(d);
+        double sum = 0.0;
+
+        // wszystkie l (l_i >= 1) z q-d+1 <= |l| <= q, współczynnik (-1)^(q-|l|) C(d-1, q-|l|)
+        std::function<void(int, int)> rec = [&](int i, int used) {
+            if (i == d) {
+                const int k = q - used;
+                if (k < 0 || k > d - 1) return;
+                double c = 1.0;
+                for (int j = 1; j <= k; ++j) c = c * (d - k + j - 1) / j;   // C(d-1, k)
+                if (k % 2) c = -c;
+                for (int j = 0; j < d; ++j) rules[j] = numlab::detail::gauss_rule(l[j]);
+                sum += c * tensor_rule(f, lo, hi, rules, 1, evals);
+                return;
+            }
+            const int maxL = q - used - (d - i - 1);
+            for (l[i] = 1; l[i] <= maxL; ++l[i])
+                rec(i + 1, used + l[i]);
+        };
+        rec(0, 0);
+        return sum;
+    }
+
+    // Liczby kierunkowe Joe-Kuo (new-joe-kuo-6.21201) dla wymiarów 2..16: s, a, m_1..m_s
+    struct SobolPoly { int s, a; unsigned m[6]; };
+    const SobolPoly SOBOL_POLY[15] = {
+        { 1,  0, { 1 } },
+        { 2,  1, { 1, 3 } },
+        { 3,  1, { 1, 3, 1 } },
+        { 3,  2, { 1, 1, 1 } },
+        { 4,  1, { 1, 1, 3, 3 } },
+        { 4,  4, { 1, 3, 5, 13 } },
+        { 5,  2, { 1, 1, 5, 5, 17 } },
+        { 5,  4, { 1, 1, 5, 5, 5 } },
+        { 5,  7, { 1, 1, 7, 11, 19 } },
+        { 5, 11, { 1, 1, 5, 1, 1 } },
+        { 5, 13, { 1, 1, 1, 3, 11 } },
+        { 5, 14, { 1, 3, 5, 5, 31 } },
+        { 6,  1, { 1, 3, 3, 9, 7, 49 } },
+        { 6, 13, { 1, 1, 1, 15, 21, 21 } },
+        { 6, 16, { 1, 3, 1, 13, 27, 49 } },
+    };
+    constexpr int SOBOL_MAX_DIM = 16;
+    constexpr int SOBOL_BITS = 32;
+
+    // v[j][k] - k-ta liczba kierunkowa wymiaru j, wyrównana do 32 bitów
+    std::vector<std::vector<std::uint32_t>> sobol_directions(int d)
+    {
+        std::vector<std::vector<std::uint32_t>> v(d, std::vector<std::uint32_t>(SOBOL_BITS));
+        for (int k = 0; k < SOBOL_BITS; ++k)
+            v[0][k] = 1u << (SOBOL_BITS - 1 - k);
+        for (int j = 1; j < d; ++j) {
+            const SobolPoly& p = SOBOL_POLY[j - 1];
+            for (int k = 0; k < p.s && k < SOBOL_BITS; ++k)
+                v[j][k] = p.m[k] << (SOBOL_BITS - 1 - k);
+            for (int k = p.s; k < SOBOL_BITS; ++k) {
+                std::uint32_t x = v[j][k - p.s] ^ (v[j][k - p.s] >> p.s);
+                for (int i = 1; i < p.s; ++i)
+                    if ((p.a >> (p.s - 1 - i)) & 1)
+                        x ^= v[j][k - i];
+                v[j][k] = x;
+            }
+        }
+        return v;
+    }
+
+}
+
+namespace numlab {
+
+    CubatureResult cubature_gauss(const IntegrandND& f,
+        const Vector& lo, const Vector& hi, int nG, int threads)
+    {
+        const int d = check_box(lo, hi);
+        if (nG < 1) throw std::invalid_argument("nG musi być >= 1");
+
+        CubatureResult res;
+        std::vector<detail::GaussRule> rules(d, detail::gauss_rule(nG));
+        res.value = tensor_rule(f, lo, hi, rules, threads, res.evaluations);
+        if (nG > 1) {
+            std::fill(rules.begin(), rules.end(), detail::gauss_rule(nG - 1));
+            res.error = std::fabs(res.value - tensor_rule(f, lo, hi, rules, threads, res.evaluations));
+        }
+        else {
+            res.error = std::numeric_limits<double>::infinity();
+        }
+        return res;
+    }
+
+    CubatureResult cubature_sparse_grid(const IntegrandND& f,
+        const Vector& lo, const Vector& hi, int level)
+    {
+        check_box(lo, hi);
+        if (level < 0) throw std::invalid_argument("level < 0");
+
+        CubatureResult res;
+        res.value = smolyak(f, lo, hi, level, res.evaluations);
+        res.error = level > 0
+            ? std::fabs(res.value - smolyak(f, lo, hi, level - 1, res.evaluations))
+            : std::numeric_limits<double>::infinity();
+        return res;
+    }
+
+    CubatureResult cubature_qmc(const IntegrandND& f,
+        const Vector& lo, const Vector& hi,
+        long long n, int replicas, int threads, std::uint64_t seed)
+    {
+        const int d = check_box(lo, hi);
+        if (d > SOBOL_MAX_DIM) throw std::invalid_argument("QMC: wymiar > 16");
+        if (n < 1 || n > (1LL << SOBOL_BITS)) throw std::invalid_argument("QMC: n poza zakresem");
+        if (replicas < 1) throw std::invalid_argument("QMC: replicas < 1");
+
+        const auto v = sobol_directions(d);
+        std::mt19937_64 rng(seed);
+        std::vector<std::uint32_t> shift(static_cast<std::size_t>(replicas) * d);
+        for (auto& s : shift) s = static_cast<std::uint32_t>(rng() >> 32);
+
+        double vol = 1.0;
+        for (int i = 0; i < d; ++i) vol *= hi[i] - lo[i];
+
+        const long long nb = (n + CUB_BLOCK - 1) / CUB_BLOCK;
+        const long long tasks = nb * replicas;
+        if (tasks > std::numeric_limits<int>::max())
+            throw std::invalid_argument("QMC: zbyt wiele punktów");
+        Vector part(static_cast<std::size_t>(tasks));
+
+        detail::SharedPool pool(tasks > 1 ? detail::resolve_threads(threads) : 1);
+        pool.parallel_for(0, static_cast<int>(tasks), 1, [&](int t0, int t1) {
+            Vector x(d);
+            std::vector<std::uint32_t> X(d);
+            const double scale = 1.0 / 4294967296.0;            // 2^-32
+            for (int t = t0; t < t1; ++t) {
+                const int r = static_cast<int>(t / nb);
+                const long long s = (t % nb) * CUB_BLOCK, e = std::min(s + CUB_BLOCK, n);
+                const std::uint32_t* sh = shift.data() + static_cast<std::size_t>(r) * d;
+
+                // punkt startowy bloku wprost z kodu Graya, dalej po jednym XOR na punkt
+                const unsigned long long g = static_cast<unsigned long long>(s) ^ (static_cast<unsigned long long>(s) >> 1);
+                for (int j = 0; j < d; ++j) {
+                    std::uint32_t acc = 0;
+                    for (int k = 0; k < SOBOL_BITS; ++k)
+                        if ((g >> k) & 1) acc ^= v[j][k];
+                    X[j] = acc;
+                }
+
+                double sum = 0.0;
+                for (long long i = s; i < e; ++i) {
+                    if (i > s) {
+                        int c = 0;
+                        while (((i >> c) & 1) == 0) ++c;
+                        for (int j = 0; j < d; ++j) X[j] ^= v[j][c];
+                    }
+                    for (int j = 0; j < d; ++j)
+                        x[j] = lo[j] + (hi[j] - lo[j]) * ((static_cast<double>(X[j] ^ sh[j]) + 0.5) * scale);
+                    sum += f(x);
+                }
+                part[t] = sum;
+            }
+        });
+
+        CubatureResult res;
+        res.evaluations = n * replicas;
+        Vector est(replicas);
+        for (int r = 0; r < replicas; ++r)
+            est[r] = detail::pairwise_sum(part.data() + r * nb, static_cast<int>(nb)) / static_cast<double>(n) * vol;
+        double mean = 0.0;
+        for (double e : est) mean += e;
+        mean /= replicas;
+        double var = 0.0;
+        for (double e : est) var += (e - mean) * (e - mean);
+        res.value = mean;
+        res.error = replicas > 1 ? std::sqrt(var / (replicas - 1) / replicas)
+                                 : std::numeric_limits<double>::infinity();
+        return res;
+    }
+
+}
@@ -1,7 +1,311 @@
 ﻿#include "differential.h"
+#include "ode_detail.h"
+#include "nlsolve.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <utility>
 
 namespace numlab {
 
+    namespace {
+
+        // Tablica Butchera pary zagnieżdżonej: b - rozwiązanie (wyższy rząd,
+        // lokalna ekstrapolacja), bhat - rozwiązanie pomocnicze do oszacowania błędu.
+        // fsal: ostatni etap liczony w (t+h, y_new) = pierwszy etap następnego kroku.
+        struct RKTableau {
+            int    s;             // liczba etapów
+            int    q;             // rząd niższy -> wykładnik 1/(q+1) w sterowniku
+            bool   fsal;
+            double c[7];
+            double a[7][6];
+            double b[7];
+            double bhat[7];
+        };
+
+        const RKTableau DOPRI5 = {
+            7, 4, true,
+            { 0.0, 1.0 / 5, 3.0 / 10, 4.0 / 5, 8.0 / 9, 1.0, 1.0 },
+            { {},
+              { 1.0 / 5 },
+              { 3.0 / 40, 9.0 / 40 },
+              { 44.0 / 45, -56.0 / 15, 32.0 / 9 },
+              { 19372.0 / 6561, -25360.0 / 2187, 64448.0 / 6561, -212.0 / 729 },
+              { 9017.0 / 3168, -355.0 / 33, 46732.0 / 5247, 49.0 / 176, -5103.0 / 18656 },
+              { 35.0 / 384, 0.0, 500.0 / 1113, 125.0 / 192, -2187.0 / 6784, 11.0 / 84 } },
+            { 35.0 / 384, 0.0, 500.0 / 1113, 125.0 / 192, -2187.0 / 6784, 11.0 / 84, 0.0 },
+            { 5179.0 / 57600, 0.0, 7571.0 / 16695, 393.0 / 640, -92097.0 / 339200, 187.0 / 2100, 1.0 / 40 }
+        };
+
+        const RKTableau CASH_KARP = {
+            6, 4, false,
+            { 0.0, 1.0 / 5, 3.0 / 10, 3.0 / 5, 1.0, 7.0 / 8 },
+            { {},
+              { 1.0 / 5 },
+              { 3.0 / 40, 9.0 / 40 },
+              { 3.0 / 10, -9.0 / 10, 6.0 / 5 },
+              { -11.0 / 54, 5.0 / 2, -70.0 / 27, 35.0 / 27 },
+              { 1631.0 / 55296, 175.0 / 512, 575.0 / 13824, 44275.0 / 110592, 253.0 / 4096 } },
+            { 37.0 / 378, 0.0, 250.0 / 621, 125.0 / 594, 0.0, 512.0 / 1771 },
+            { 2825.0 / 27648, 0.0, 18575.0 / 48384, 13525.0 / 55296, 277.0 / 14336, 1.0 / 4 }
+        };
+
+        const RKTableau BS23 = {
+            4, 2, true,
+            { 0.0, 1.0 / 2, 3.0 / 4, 1.0 },
+            { {},
+              { 1.0 / 2 },
+              { 0.0, 3.0 / 4 },
+              { 2.0 / 9, 1.0 / 3, 4.0 / 9 } },
+            { 2.0 / 9, 1.0 / 3, 4.0 / 9, 0.0 },
+            { 7.0 / 24, 1.0 / 4, 1.0 / 3, 1.0 / 8 }
+        };
+
+        const RKTableau& rk_tableau(OdeMethod m)
+        {
+            switch (m) {
+            case OdeMethod::DormandPrince45:   return DOPRI5;
+            case OdeMethod::CashKarp45:        return CASH_KARP;
+            case OdeMethod::BogackiShampine23: return BS23;
+            default: break;
+            }
+            throw std::invalid_argument("Nieznana metoda RK");
+        }
+
+        constexpr double SAFETY = 0.9;
+        constexpr double FAC_MIN = 0.2, FAC_MAX = 5.0;
+
+        // Rozszerzenie ciągłe Dormanda-Prince'a rzędu 4 (Hairer, dopri5 - contd5).
+        // Współczynniki liczone dopiero przy pierwszym eval - koszt tylko przy gęstym wyjściu.
+        class Dopri5Dense final : public detail::DenseStep {
+        public:
+            Dopri5Dense(int n, double t0, double h, const double* y0, const double* y1,
+                double* const* k, double* r)
+                : n_(n), t0_(t0), h_(h), y0_(y0), y1_(y1), k_(k), r_(r) {}
+
+            void eval(double t, double* y) const override
+            {
+                static constexpr double D1 = -12715105075.0 / 11282082432.0, D3 = 87487479700.0 / 32700410799.0,
+                    D4 = -10690763975.0 / 1880347072.0, D5 = 701980252875.0 / 199316789632.0,
+                    D6 = -1453857185.0 / 822651844.0, D7 = 69997945.0 / 29380423.0;
+                double* r1 = r_; double* r2 = r_ + n_; double* r3 = r2 + n_; double* r4 = r3 + n_;
+                if (!ready_) {
+                    for (int i = 0; i < n_; ++i) {
+                        const double dy = y1_[i] - y0_[i], bspl = h_ * k_[0][i] - dy;
+                        r1[i] = dy;
+                        r2[i] = bspl;
+                        r3[i] = dy - h_ * k_[6][i] - bspl;
+                        r4[i] = h_ * (D1 * k_[0][i] + D3 * k_[2][i] + D4 * k_[3][i]
+                            + D5 * k_[4][i] + D6 * k_[5][i] + D7 * k_[6][i]);
+                    }
+                    ready_ = true;
+                }
+                const double s = (t - t0_) / h_, s1 = 1.0 - s;
+                for (int i = 0; i < n_; ++i)
+                    y[i] = y0_[i] + s * (r1[i] + s1 * (r2[i] + s * (r3[i] + s1 * r4[i])));
+            }
+
+        private:
+            int n_;
+            double t0_, h_;
+            const double *y0_, *y1_;
+            double* const* k_;
+            double* r_;
+            mutable bool ready_ = false;
+        };
+
+        // Rdzeń całkowania adaptacyjnego dla układu n równań:
+        // rhs(t, const double* y, double* dy), emit(t, y, dense) po każdym przyjętym kroku.
+        // Cała pamięć robocza alokowana raz przed pętlą.
+        template<class Rhs, class Emit>
+        void rk_adaptive(const RKTableau& T, Rhs& rhs, int n, double* y,
+            double t, double tEnd, const OdeOptions& opt, OdeStats& st, Emit& emit)
+        {
+            std::vector<double> work(static_cast<std::size_t>(T.s + 8) * n);
+            double* k[7];
+            for (int j = 0; j < T.s; ++j) k[j] = work.data() + static_cast<std::size_t>(j) * n;
+            double* ytmp = work.data() + static_cast<std::size_t>(T.s) * n;
+            double* ynew = ytmp + n;
+            double* err = ynew + n;
+            double* fnew = err + n;             // f(t+h, y_new) dla metod bez FSAL
+            double* rcont = fnew + n;           // 4n - współczynniki gęstego wyjścia DOPRI5
+            const bool dopri = &T == &DOPRI5;
+
+            const int kexp = T.q + 1;
+            const double alpha = 0.7 / kexp, beta = 0.4 / kexp;      // sterownik PI (Gustafsson)
+
+            rhs(t, static_cast<const double*>(y), k[0]);
+            ++st.evaluations;
+            emit(t, static_cast<const double*>(y), static_cast<const detail::DenseStep*>(nullptr));
+
+            double h = opt.h0 > 0.0 ? opt.h0
+                : detail::initial_step(rhs, n, t, y, k[0], tEnd - t, T.q, opt, ytmp, err, st);
+            h = std::min(h, opt.hMax);
+            double errPrev = 1e-4;
+            bool lastRejected = false;
+
+            while (t < tEnd) {
+                if (st.accepted + st.rejected >= opt.maxSteps) return;
+                const double hMin = std::max(opt.hMin, 16 * std::numeric_limits<double>::epsilon() * std::fabs(t));
+                if (h < hMin) return;
+
+                bool last = false;
+                if (t + h >= tEnd) { h = tEnd - t; last = true; }
+
+                for (int j = 1; j < T.s; ++j) {
+                    for (int i = 0; i < n; ++i) {
+                        double acc = 0.0;
+                        for (int m = 0; m < j; ++m) acc += T.a[j][m] * k[m][i];
+                        ytmp[i] = y[i] + h * acc;
+                    }
+                    rhs(t + T.c[j] * h, static_cast<const double*>(ytmp), k[j]);
+                }
+                st.evaluations += T.s - 1;
+
+                for (int i = 0; i < n; ++i) {
+                    double sb = 0.0, se = 0.0;
+                    for (int j = 0; j < T.s; ++j) {
+                        sb += T.b[j] * k[j][i];
+                        se += (T.b[j] - T.bhat[j]) * k[j][i];
+                    }
+                    ynew[i] = y[i] + h * sb;
+                    err[i] = h * se;
+                }
+                const double e = detail::scaled_norm(n, err, y, ynew, opt);
+
+                if (e <= 1.0) {
+                    ++st.accepted;
+                    const double tNew = last ? tEnd : t + h;
+                    double* f1 = k[T.s - 1];
+                    if (!T.fsal) {
+                        rhs(tNew, static_cast<const double*>(ynew), fnew);
+                        ++st.evaluations;
+                        f1 = fnew;
+                    }
+                    bool go;
+                    if (dopri) {
+                        const Dopri5Dense dense(n, t, h, y, ynew, k, rcont);
+                        go = emit(tNew, static_cast<const double*>(ynew), static_cast<const detail::DenseStep*>(&dense));
+                    }
+                    else {
+                        const detail::HermiteDense dense(n, t, tNew, y, k[0], ynew, f1);
+                        go = emit(tNew, static_cast<const double*>(ynew), static_cast<const detail::DenseStep*>(&dense));
+                    }
+                    if (!go) { st.success = true; return; }
+                    t = tNew;
+                    std::copy(ynew, ynew + n, y);
+                    if (T.fsal) std::swap(k[0], k[T.s - 1]);
+                    else std::copy(fnew, fnew + n, k[0]);
+
+                    double fac = e > 0.0 ? SAFETY * std::pow(e, -alpha) * std::pow(errPrev, beta) : FAC_MAX;
+                    fac = std::min(FAC_MAX, std::max(FAC_MIN, fac));
+                    if (lastRejected) fac = std::min(fac, 1.0);
+                    h = std::min(h * fac, opt.hMax);
+                    errPrev = std::max(e, 1e-4);
+                    lastRejected = false;
+                }
+                else {
+                    ++st.rejected;
+                    h *= std::max(FAC_MIN, SAFETY * std::pow(e, -1.0 / kexp));
+                    lastRejected = true;
+                }
+            }
+            st.success = true;
+        }
+
+        // Wykrywanie zdarzeń: znak g_i na końcach każdego przyjętego kroku, przecięcia
+        // lokalizowane metodą Brenta na gęstym wyjściu i obsługiwane w kolejności czasu.
+        class EventTracker {
+        public:
+            EventTracker(const std::vector<OdeEvent>& ev, int n)
+                : ev_(ev), n_(n), g_(ev.size()), ev_y_(n)
+            {
+                for (const OdeEvent& e : ev_)
+                    if (!e.g) throw std::invalid_argument("puste zdarzenie g");
+            }
+
+            bool empty() const { return ev_.empty(); }
+
+            void start(double t, const double* y)
+            {
+                for (std::size_t i = 0; i < ev_.size(); ++i) g_[i] = ev_[i].g(t, y);
+                tPrev_ = t;
+            }
+
+            // true - zdarzenie terminalne w chwili stop_t(), stan w stop_y()
+            bool step(double t, const double* y, const detail::DenseStep& dense, std::vector<OdeEventHit>& hits)
+            {
+                found_.clear();
+                for (std::size_t i = 0; i < ev_.size(); ++i) {
+                    const double g0 = g_[i], g1 = ev_[i].g(t, y);
+                    g_[i] = g1;
+                    const bool rising = g0 < 0.0 && g1 >= 0.0, falling = g0 > 0.0 && g1 <= 0.0;
+                    if (!(ev_[i].direction >= 0 && rising) && !(ev_[i].direction <= 0 && falling)) continue;
+                    double tr = t;
+                    if (g1 != 0.0) {
+                        const OdeEvent& e = ev_[i];
+                        auto gt = [&](double s) { dense.eval(s, ev_y_.data()); return e.g(s, ev_y_.data()); };
+                        const double eps = 4 * std::numeric_limits<double>::epsilon() * std::max(std::fabs(tPrev_), std::fabs(t));
+                        const RootResult rr = root_brent(gt, tPrev_, t, std::max(eps, EVENT_TOL * (t - tPrev_)), NL_MAX_ITER);
+                        if (!std::isnan(rr.root)) tr = rr.root;
+                    }
+                    found_.push_back({ tr, static_cast<int>(i) });
+                }
+                tPrev_ = t;
+                std::sort(found_.begin(), found_.end());
+                for (const auto& fe : found_) {
+                    if (fe.first == t) std::copy(y, y + n_, ev_y_.begin());
+                    else dense.eval(fe.first, ev_y_.data());
+                    hits.push_back({ fe.second, fe.first, ev_y_ });
+                    if (ev_[fe.second].terminal) { tStop_ = fe.first; return true; }
+                }
+                return false;
+            }
+
+            double stop_t() const { return tStop_; }
+            const double* stop_y() const { return ev_y_.data(); }
+
+        private:
+            static constexpr double EVENT_TOL = 1e-12;     // względem długości kroku
+
+            const std::vector<OdeEvent>& ev_;
+            int n_;
+            Vector g_, ev_y_;
+            std::vector<std::pair<double, int>> found_;
+            double tPrev_ = 0.0, tStop_ = 0.0;
+        };
+
+        // wybór metody: jawna para RK (szablon, bez std::function) albo sztywna z ode_stiff.cpp;
+        // emit(t, y, dense) widzi punkty kroków, a przy zdarzeniu terminalnym ostatnim
+        // punktem jest chwila zdarzenia (stan zapisywany też do y).
+        template<class Rhs, class Emit>
+        void ode_adaptive(Rhs& rhs, int n, double* y,
+            double t0, double tEnd, const OdeOptions& opt, OdeStats& st, Emit& emit)
+        {
+            detail::check_ode_args(t0, tEnd, opt);
+            EventTracker events(opt.events, n);
+            auto step = [&](double t, const double* yt, const detail::DenseStep* dense) {
+                if (events.empty()) { emit(t, yt, dense); return true; }
+                if (dense == nullptr) { events.start(t, yt); emit(t, yt, dense); return true; }
+                if (!events.step(t, yt, *dense, st.hits)) { emit(t, yt, dense); return true; }
+                st.terminated = true;
+                emit(events.stop_t(), events.stop_y(), dense);
+                std::copy(events.stop_y(), events.stop_y() + n, y);
+                return false;
+            };
+            if (detail::is_stiff(opt.method))
+                detail::ode_stiff(OdeSystemRHS(rhs), n, y, t0, tEnd, opt, st, detail::OdeEmit(std::ref(step)));
+            else
+                rk_adaptive(rk_tableau(opt.method), rhs, n, y, t0, tEnd, opt, st, step);
+        }
+
+    }
+
     double step_euler(double y, double t, double h, const OdeRHS& f)
     {
         return y + h * f(t, y);
@@ -46,4 +350,177 @@ namespace numlab {
         return traj;
     }
 
-} 
+    std::vector<StatePoint>
+        ode_solve(double y0, double t0, double tEnd,
+            const OdeRHS& f, const OdeOptions& opt, OdeStats* stats)
+    {
+        OdeStats st;
+        std::vector<StatePoint> traj;
+        auto rhs = [&f](double t, const double* y, double* dy) { dy[0] = f(t, y[0]); };
+        auto emit = [&traj](double t, const double* y, const detail::DenseStep*) { traj.push_back({ t, y[0] }); };
+        double y = y0;
+        ode_adaptive(rhs, 1, &y, t0, tEnd, opt, st, emit);
+        if (stats) *stats = st;
+        return traj;
+    }
+
+    namespace {
+
+        void check_workspace(int n, const OdeWorkspace& ws)
+        {
+            if (n <= 0 || ws.size() < n) throw std::invalid_argument("OdeWorkspace za mały dla układu");
+        }
+
+    }
+
+    void step_euler_sys(double* y, int n, double t, double h, const OdeSystemRHS& f, OdeWorkspace& ws)
+    {
+        check_workspace(n, ws);
+        double* k1 = ws.stage(0);
+        f(t, y, k1);
+        for (int i = 0; i < n; ++i) y[i] += h * k1[i];
+    }
+
+    void step_heun_sys(double* y, int n, double t, double h, const OdeSystemRHS& f, OdeWorkspace& ws)
+    {
+        check_workspace(n, ws);
+        double* k1 = ws.stage(0); double* k2 = ws.stage(1); double* yt = ws.stage(4);
+        f(t, y, k1);
+        for (int i = 0; i < n; ++i) yt[i] = y[i] + h * k1[i];
+        f(t + h, yt, k2);
+        for (int i = 0; i < n; ++i) y[i] += 0.5 * h * (k1[i] + k2[i]);
+    }
+
+    void step_midpoint_sys(double* y, int n, double t, double h, const OdeSystemRHS& f, OdeWorkspace& ws)
+    {
+        check_workspace(n, ws);
+        double* k1 = ws.stage(0); double* k2 = ws.stage(1); double* yt = ws.stage(4);
+        f(t, y, k1);
+        for (int i = 0; i < n; ++i) yt[i] = y[i] + 0.5 * h * k1[i];
+        f(t + 0.5 * h, yt, k2);
+        for (int i = 0; i < n; ++i) y[i] += h * k2[i];
+    }
+
+    void step_rk4_sys(double* y, int n, double t, double h, const OdeSystemRHS& f, OdeWorkspace& ws)
+    {
+        check_workspace(n, ws);
+        double* k1 = ws.stage(0); double* k2 = ws.stage(1);
+        double* k3 = ws.stage(2); double* k4 = ws.stage(3); double* yt = ws.stage(4);
+        f(t, y, k1);
+        for (int i = 0; i < n; ++i) yt[i] = y[i] + 0.5 * h * k1[i];
+        f(t + 0.5 * h, yt, k2);
+        for (int i = 0; i < n; ++i) yt[i] = y[i] + 0.5 * h * k2[i];
+        f(t + 0.5 * h, yt, k3);
+        for (int i = 0; i < n; ++i) yt[i] = y[i] + h * k3[i];
+        f(t + h, yt, k4);
+        for (int i = 0; i < n; ++i) y[i] += h * (k1[i] + 2 * k2[i] + 2 * k3[i] + k4[i]) / 6.0;
+    }
+
+    OdeTrajectory
+        ode_solve_system(const Vector& y0, double t0, double tEnd, double h,
+            const OdeSystemRHS& f, const OdeSystemStep& step)
+    {
+        if (y0.empty()) throw std::invalid_argument("pusty wektor stanu");
+        if (!(h > 0.0)) throw std::invalid_argument("h <= 0");
+        if (!(tEnd > t0)) throw std::invalid_argument("tEnd <= t0");
+
+        const int n = static_cast<int>(y0.size());
+        const long long N = static_cast<long long>((tEnd - t0) / h + 1e-9);
+        const bool tail = t0 + N * h < tEnd - 1e-12;
+        const std::size_t pts = static_cast<std::size_t>(N) + 1 + (tail ? 1 : 0);
+
+        OdeTrajectory tr;
+        tr.dim = n;
+        tr.t.reserve(pts);
+        tr.y.reserve(pts * n);
+        OdeWorkspace ws(n);
+        Vector y = y0;
+
+        tr.t.push_back(t0);
+        tr.y.insert(tr.y.end(), y.begin(), y.end());
+        for (long long i = 0; i < N; ++i) {
+            const double t = t0 + i * h;
+            step(y.data(), n, t, h, f, ws);
+            tr.t.push_back(t0 + (i + 1) * h);
+            tr.y.insert(tr.y.end(), y.begin(), y.end());
+        }
+        if (tail) {
+            const double t = t0 + N * h;
+            step(y.data(), n, t, tEnd - t, f, ws);
+            tr.t.push_back(tEnd);
+            tr.y.insert(tr.y.end(), y.begin(), y.end());
+        }
+        return tr;
+    }
+
+    OdeTrajectory
+        ode_solve_system(const Vector& y0, double t0, double tEnd,
+            const OdeSystemRHS& f, const OdeOptions& opt, OdeStats* stats)
+    {
+        if (y0.empty()) throw std::invalid_argument("pusty wektor stanu");
+
+        OdeStats st;
+        OdeTrajectory tr;
+        tr.dim = static_cast<int>(y0.size());
+        auto emit = [&tr](double t, const double* y, const detail::DenseStep*) {
+            tr.t.push_back(t);
+            tr.y.insert(tr.y.end(), y, y + tr.dim);
+        };
+        Vector y = y0;
+        ode_adaptive(f, tr.dim, y.data(), t0, tEnd, opt, st, emit);
+        if (stats) *stats = st;
+        return tr;
+    }
+
+    Vector
+        ode_integrate(const Vector& y0, double t0, double tEnd,
+            const OdeSystemRHS& f, const OdeOptions& opt, const OdeOutput& out, OdeStats* stats)
+    {
+        if (y0.empty()) throw std::invalid_argument("pusty wektor stanu");
+        if (out.decimate < 1) throw std::invalid_argument("decimate < 1");
+        const Vector& grid = out.grid;
+        for (std::size_t i = 0; i < grid.size(); ++i)
+            if (!(grid[i] >= t0 && grid[i] <= tEnd) || (i > 0 && grid[i] < grid[i - 1]))
+                throw std::invalid_argument("siatka wyjścia poza [t0, tEnd] lub nieposortowana");
+
+        const int n = static_cast<int>(y0.size());
+        OdeStats st;
+        Vector y = y0, yg(grid.empty() ? 0 : n);
+        std::size_t next = 0;
+        long long steps = 0;
+        auto emit = [&](double t, const double* yt, const detail::DenseStep* dense) {
+            if (!out.observer) return;
+            if (grid.empty()) {
+                if (dense == nullptr || ++steps % out.decimate == 0 || t >= tEnd || st.terminated) out.observer(t, yt, n);
+                return;
+            }
+            for (; next < grid.size() && grid[next] <= t; ++next) {
+                if (grid[next] == t || dense == nullptr) { out.observer(grid[next], yt, n); continue; }
+                dense->eval(grid[next], yg.data());
+                out.observer(grid[next], yg.data(), n);
+            }
+        };
+        ode_adaptive(f, n, y.data(), t0, tEnd, opt, st, emit);
+        if (stats) *stats = st;
+        return y;
+    }
+
+    OdeObserver ode_csv_writer(std::ostream& os, char sep)
+    {
+        os.precision(std::numeric_limits<double>::max_digits10);
+        return [&os, sep](double t, const double* y, int n) {
+            os << t;
+            for (int i = 0; i < n; ++i) os << sep << y[i];
+            os << '\n';
+        };
+    }
+
+    OdeObserver ode_csv_file(const std::string& path, char sep)
+    {
+        auto file = std::make_shared<std::ofstream>(path);
+        if (!*file) throw std::runtime_error("nie można otworzyć pliku: " + path);
+        OdeObserver write = ode_csv_writer(*file, sep);
+        return [file, write](double t, const double* y, int n) { write(t, y, n); };
+    }
+
+}
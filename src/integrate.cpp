@@ -1,6 +1,13 @@
 ﻿#include "integrate.h"
+#include "parallel.h"
+#include "poly.h"
 #include <cmath>
 #include <stdexcept>
+#include <atomic>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
 
 namespace numlab {
 
@@ -13,70 +20,146 @@ namespace numlab {
         return res;
     }
 
+    using Fn = const std::function<double(double)>&;
+
     double integral_midpoint(const std::function<double(double)>& f,
         double a, double b, int n)
     {
-        if (n <= 0) throw std::invalid_argument("n <= 0");
-        double h = (b - a) / n, sum = 0.0;
-        for (int i = 0; i < n; ++i)
-            sum += f(a + (i + 0.5) * h);
-        return sum * h;
+        return integral_midpoint<Fn>(f, a, b, n);
     }
 
     double integral_trapezoid(const std::function<double(double)>& f,
         double a, double b, int n)
     {
-        if (n <= 0) throw std::invalid_argument("n <= 0");
-        double h = (b - a) / n;
-        double sum = 0.5 * (f(a) + f(b));
-        for (int i = 1; i < n; ++i)
-            sum += f(a + i * h);
-        return sum * h;
+        return integral_trapezoid<Fn>(f, a, b, n);
     }
 
     double integral_simpson(const std::function<double(double)>& f,
         double a, double b, int n)
     {
-        if (n % 2) ++n;                       
-        double h = (b - a) / n, sum = f(a) + f(b);
-        for (int i = 1; i < n; ++i) {
-            double x = a + i * h;
-            sum += (i % 2 ? 4.0 : 2.0) * f(x);
+        return integral_simpson<Fn>(f, a, b, n);
+    }
+
+    namespace {
+
+        struct GaussTable { Vector x, w; };
+
+        // Węzły = pierwiastki P_n, liczone metodą Newtona z rekurencji Bonneta;
+        // wagi w_i = 2 / ((1 - x_i^2) P_n'(x_i)^2). Dokładność rzędu ulp.
+        std::unique_ptr<GaussTable> build_gauss(int n)
+        {
+            const double pi = 3.14159265358979323846;
+            auto t = std::make_unique<GaussTable>();
+            t->x.resize(n);
+            t->w.resize(n);
+            // P_n(x) i P_n'(x) z rekurencji Bonneta
+            auto legendre = [n](double x, double& dp) {
+                double p0 = 1.0, p1 = x;
+                for (int k = 2; k <= n; ++k) {
+                    const double p2 = ((2 * k - 1) * x * p1 - (k - 1) * p0) / k;
+                    p0 = p1; p1 = p2;
+                }
+                dp = (n == 1) ? 1.0 : n * (x * p1 - p0) / (x * x - 1.0);
+                return p1;
+            };
+            const double tol = 4 * std::numeric_limits<double>::epsilon();
+            for (int i = 0; i < (n + 1) / 2; ++i) {
+                double x = std::cos(pi * (i + 0.75) / (n + 0.5)), dp = 0.0;
+                for (int it = 0; it < 100; ++it) {
+                    const double dx = legendre(x, dp) / dp;
+                    x -= dx;
+                    if (std::fabs(dx) <= tol * std::fabs(x)) break;
+                }
+                // jeszcze jedna poprawka (zbieżność kwadratowa -> błąd rzędu ulp),
+                // potem P_n'(x) w ostatecznym węźle
+                x -= legendre(x, dp) / dp;
+                legendre(x, dp);
+                if (2 * i + 1 == n) x = 0.0;               // węzeł środkowy dokładnie w zerze
+                const double w = 2.0 / ((1.0 - x * x) * dp * dp);
+                t->x[i] = -x;         t->w[i] = w;           // kolejność rosnąca
+                t->x[n - 1 - i] = x;  t->w[n - 1 - i] = w;
+            }
+            return t;
+        }
+
+        // Tablice liczone raz i trzymane do końca programu. Dla małych nG odczyt
+        // jest bez blokady (atomowy wskaźnik), większe nG - mapa pod muteksem.
+        constexpr int GAUSS_FAST = 128;
+        std::atomic<const GaussTable*> g_fast[GAUSS_FAST];
+        std::mutex g_mutex;
+        std::map<int, std::unique_ptr<GaussTable>> g_tables;
+
+        const GaussTable& gauss_table(int n)
+        {
+            if (n < GAUSS_FAST) {
+                if (const GaussTable* t = g_fast[n].load(std::memory_order_acquire))
+                    return *t;
+            }
+            std::lock_guard<std::mutex> lk(g_mutex);
+            auto& slot = g_tables[n];
+            if (!slot) slot = build_gauss(n);
+            if (n < GAUSS_FAST)
+                g_fast[n].store(slot.get(), std::memory_order_release);
+            return *slot;
         }
-        return sum * h / 3.0;
+
     }
 
-    static const double X2[] = { -1 / std::sqrt(3.0),  1 / std::sqrt(3.0) };
-    static const double W2[] = { 1.0, 1.0 };
-    static const double X3[] = { -std::sqrt(3.0 / 5.0), 0.0,  std::sqrt(3.0 / 5.0) };
-    static const double W3[] = { 5.0 / 9.0, 8.0 / 9.0, 5.0 / 9.0 };
-    static const double X4[] = { -0.861136, -0.339981, 0.339981, 0.861136 };
-    static const double W4[] = { 0.347855, 0.652145, 0.652145, 0.347855 };
+    namespace detail {
+
+        void run_blocks(int nBlocks, int threads, const std::function<void(int, int)>& body)
+        {
+            SharedPool pool(nBlocks > 1 ? resolve_threads(threads) : 1);
+            pool.parallel_for(0, nBlocks, 1, body);
+        }
+
+        GaussRule gauss_rule(int nG)
+        {
+            if (nG < 1) throw std::invalid_argument("nG musi być >= 1");
+            const GaussTable& t = gauss_table(nG);
+            return { t.x.data(), t.w.data(), nG };
+        }
+
+    }
 
     double integral_gauss_legendre(const std::function<double(double)>& f,
         double a, double b, int nG, int m)
     {
-        const double* X, * W; int k;
-        if (nG == 2) { X = X2; W = W2; k = 2; }
-        else if (nG == 3) { X = X3; W = W3; k = 3; }
-        else if (nG == 4) { X = X4; W = W4; k = 4; }
-        else throw std::invalid_argument("nG musi być 2,3 lub 4");
-
-        if (m <= 0) throw std::invalid_argument("m <= 0");
-        double h = (b - a) / m, sum = 0.0;
-
-        for (int j = 0; j < m; ++j) {
-            double aj = a + j * h, bj = aj + h;
-            double mid = 0.5 * (aj + bj), half = 0.5 * (bj - aj);
-            for (int i = 0; i < k; ++i)
-                sum += W[i] * f(mid + half * X[i]);
-        }
-        return sum * (h / 2.0);
+        return integral_gauss_legendre<Fn>(f, a, b, nG, m);
+    }
+
+    QuadResult integral_adaptive(const std::function<double(double)>& f,
+        double a, double b, double absTol, double relTol, int maxEval)
+    {
+        return integral_adaptive<Fn>(f, a, b, absTol, relTol, maxEval);
     }
 
-    static std::function<double(double)> make_poly(const Vector& a)
+    RombergResult integral_romberg(const std::function<double(double)>& f,
+        double a, double b, double absTol, double relTol, int maxLevel)
     {
-        return [&a](double x) { return horner(a, x); };
+        return integral_romberg<Fn>(f, a, b, absTol, relTol, maxLevel);
+    }
+
+    namespace {
+
+        // Horner jako funktor: pojedynczy punkt albo cała porcja węzłów naraz
+        // (porcja idzie do jądra SIMD z poly_eval_many)
+        struct PolyEval {
+            const Vector& c;
+
+            double operator()(double x) const { return horner(c, x); }
+
+            void operator()(const double* x, double* y, std::size_t n) const
+            {
+                poly_eval_many(c, x, y, n);
+            }
+        };
+
+        PolyEval make_poly(const Vector& a)
+        {
+            return { a };
+        }
+
     }
 
     double integral_poly_midpoint(const Vector& a, double l, double r, int n) {
@@ -93,4 +176,10 @@ namespace numlab {
         return integral_gauss_legendre(make_poly(a), l, r, nG, m);
     }
 
+    double integral_poly_exact(const Vector& a, double l, double r)
+    {
+        const Vector P = poly_antiderivative(a);
+        return horner(P, r) - horner(P, l);
+    }
+
 } 
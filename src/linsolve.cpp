@@ -1,60 +1,265 @@
-#include "linsolve.h"
+﻿#include "linsolve.h"
+#include "parallel.h"
+#include "simd.h"
 #include <iostream>
 #include <cmath>
 #include <iomanip>
+#include <algorithm>
+#include <atomic>
+#include <limits>
 
 namespace {
 
-    void print_step(const numlab::Matrix& M)
+    void print_step(const numlab::DenseMatrix& M)
     {
-        for (const auto& row : M) {
-            for (double v : row)
-                std::cout << std::setw(10) << std::fixed << std::setprecision(4) << v << ' ';
+        for (int i = 0; i < M.rows(); ++i) {
+            for (int j = 0; j < M.cols(); ++j)
+                std::cout << std::setw(10) << std::fixed << std::setprecision(4) << M(i, j) << ' ';
             std::cout << '\n';
         }
         std::cout << "-------------------------------\n";
     }
 
+    constexpr double PIVOT_EPS = 1e-12;
+    constexpr int    COL_BLOCK = 256;     // szerokość pasa kolumn w aktualizacji (~L2)
+    constexpr int    ROW_GRAIN = 32;      // porcja wierszy na zadanie wątku
+    constexpr int    PARALLEL_MIN_N = 256;
+
+    // y[0..n) -= a * x[0..n)  - jądro AVX2/AVX-512 lub skalarne (simd.cpp)
+    inline void axpy_sub(double* y, const double* x, double a, int n)
+    {
+        if (n > 0) numlab::detail::simd().axpy_sub(y, x, a, n);
+    }
+
+    inline double dot(const double* x, const double* y, int n)
+    {
+        return n > 0 ? numlab::detail::simd().dot(x, y, n) : 0.0;
+    }
+
+    // Rozkład LU panelu A(k0:n, k0:k0+kb) bez blokowania; zamiany wierszy
+    // obejmują całe wiersze macierzy.
+    void lu_panel(numlab::DenseMatrix& A, std::vector<int>& piv, int k0, int kb)
+    {
+        const int n = A.rows();
+        for (int i = k0; i < k0 + kb; ++i) {
+            int maxRow = i;
+            for (int k = i + 1; k < n; ++k)
+                if (std::fabs(A(k, i)) > std::fabs(A(maxRow, i)))
+                    maxRow = k;
+            piv[i] = maxRow;
+            if (maxRow != i)
+                std::swap_ranges(A.row(i), A.row(i) + n, A.row(maxRow));
+
+            if (std::fabs(A(i, i)) < PIVOT_EPS)
+                throw std::runtime_error("Macierz osobliwa — brak rozwiązania");
+
+            const double* pivotRow = A.row(i);
+            const double inv = 1.0 / pivotRow[i];
+            const int w = k0 + kb - i - 1;
+            for (int k = i + 1; k < n; ++k) {
+                double* rowK = A.row(k);
+                rowK[i] *= inv;
+                axpy_sub(rowK + i + 1, pivotRow + i + 1, rowK[i], w);
+            }
+        }
+    }
+
+    // U12 = L11^{-1} A12  (L11 jednostkowa dolnotrójkątna, kb x kb)
+    void lu_trsm_upper(numlab::DenseMatrix& A, int k0, int kb)
+    {
+        const int n = A.rows(), j0 = k0 + kb;
+        for (int i = k0 + 1; i < k0 + kb; ++i) {
+            double* rowI = A.row(i);
+            for (int p = k0; p < i; ++p)
+                axpy_sub(rowI + j0, A.row(p) + j0, rowI[p], n - j0);
+        }
+    }
+
+    constexpr int BATCH_LANES = 64;       // układy przetwarzane razem w układzie SoA
+    constexpr int BATCH_GRAIN = 256;      // układy na zadanie wątku w układzie Packed
+
+    // Jeden mały układ w miejscu (wiersze ciągłe, b nadpisywane rozwiązaniem).
+    bool solve_small_inplace(int n, double* A, double* b)
+    {
+        for (int k = 0; k < n; ++k) {
+            int p = k;
+            for (int i = k + 1; i < n; ++i)
+                if (std::fabs(A[i * n + k]) > std::fabs(A[p * n + k]))
+                    p = i;
+            if (std::fabs(A[p * n + k]) < PIVOT_EPS)
+                return false;
+            if (p != k) {
+                std::swap_ranges(A + k * n + k, A + k * n + n, A + p * n + k);
+                std::swap(b[k], b[p]);
+            }
+            const double* rk = A + k * n;
+            for (int i = k + 1; i < n; ++i) {
+                double* ri = A + i * n;
+                const double f = ri[k] / rk[k];
+                for (int j = k + 1; j < n; ++j)
+                    ri[j] -= f * rk[j];
+                b[i] -= f * b[k];
+            }
+        }
+        for (int i = n - 1; i >= 0; --i) {
+            const double* ri = A + i * n;
+            double s = b[i];
+            for (int j = i + 1; j < n; ++j)
+                s -= ri[j] * b[j];
+            b[i] = s / ri[i];
+        }
+        return true;
+    }
+
+    // w <= BATCH_LANES układów z rozstawem ld; element (i,j) układu s: A[(i*n+j)*ld + s].
+    // Wszystkie pętle wewnętrzne biegną po układach - ciągła pamięć, jądra SIMD.
+    int solve_lanes_interleaved(int n, std::ptrdiff_t ld, double* A, double* b, int w, int* info)
+    {
+        const auto& K = numlab::detail::simd();
+        auto a = [&](int i, int j) { return A + (static_cast<std::ptrdiff_t>(i) * n + j) * ld; };
+        auto bb = [&](int i) { return b + static_cast<std::ptrdiff_t>(i) * ld; };
+
+        double best[BATCH_LANES], f[BATCH_LANES];
+        int piv[BATCH_LANES];
+        bool bad[BATCH_LANES] = {};
+
+        for (int k = 0; k < n; ++k) {
+            const double* akk = a(k, k);
+            for (int s = 0; s < w; ++s) { best[s] = std::fabs(akk[s]); piv[s] = k; }
+            for (int i = k + 1; i < n; ++i) {
+                const double* aik = a(i, k);
+                for (int s = 0; s < w; ++s)
+                    if (std::fabs(aik[s]) > best[s]) { best[s] = std::fabs(aik[s]); piv[s] = i; }
+            }
+            for (int s = 0; s < w; ++s) {
+                if (piv[s] != k) {
+                    for (int j = k; j < n; ++j)
+                        std::swap(a(k, j)[s], a(piv[s], j)[s]);
+                    std::swap(bb(k)[s], bb(piv[s])[s]);
+                }
+                if (best[s] < PIVOT_EPS) {          // układ osobliwy - liczymy dalej na atrapie
+                    bad[s] = true;
+                    a(k, k)[s] = 1.0;
+                }
+            }
+            for (int i = k + 1; i < n; ++i) {
+                const double* aik = a(i, k);
+                for (int s = 0; s < w; ++s)
+                    f[s] = aik[s] / akk[s];
+                for (int j = k + 1; j < n; ++j)
+                    K.mul_sub(a(i, j), f, a(k, j), w);
+                K.mul_sub(bb(i), f, bb(k), w);
+            }
+        }
+        for (int i = n - 1; i >= 0; --i) {
+            double* xi = bb(i);
+            for (int j = i + 1; j < n; ++j)
+                K.mul_sub(xi, a(i, j), bb(j), w);
+            const double* aii = a(i, i);
+            for (int s = 0; s < w; ++s)
+                xi[s] /= aii[s];
+        }
+
+        int nBad = 0;
+        for (int s = 0; s < w; ++s) {
+            if (info) info[s] = bad[s] ? 1 : 0;
+            if (!bad[s]) continue;
+            ++nBad;
+            for (int i = 0; i < n; ++i)
+                bb(i)[s] = std::numeric_limits<double>::quiet_NaN();
+        }
+        return nBad;
+    }
+
+    // A22 -= L21 * U12, pasami kolumn tak, by blok U12 pozostał w cache.
+    void lu_update_rows(numlab::DenseMatrix& A, int k0, int kb, int r0, int r1)
+    {
+        const int n = A.rows(), j0 = k0 + kb;
+        for (int jb = j0; jb < n; jb += COL_BLOCK) {
+            const int w = std::min(COL_BLOCK, n - jb);
+            numlab::detail::simd().gemm_sub(A.row(r0) + jb, n, A.row(r0) + k0, n,
+                A.row(k0) + jb, n, r1 - r0, w, kb);
+        }
+    }
+
 } 
 
 namespace numlab {
 
-    Vector gaussian_elimination(Matrix A, Vector b, bool verbose)
+    DenseMatrix::DenseMatrix(int rows, int cols, double value)
+        : rows_(rows), cols_(cols),
+        data_(static_cast<std::size_t>(rows) * static_cast<std::size_t>(cols), value)
     {
-        const int n = static_cast<int>(A.size());
-        if (n == 0 || static_cast<int>(b.size()) != n)
-            throw std::runtime_error("Ze wymiary ukadu");
+        if (rows < 0 || cols < 0)
+            throw std::invalid_argument("Ujemny wymiar macierzy");
+    }
 
-        // 1. tworzymy macierz rozszerzon [A | b]
-        for (int i = 0; i < n; ++i)
-            A[i].push_back(b[i]);
+    DenseMatrix::DenseMatrix(const Matrix& M)
+        : DenseMatrix(static_cast<int>(M.size()), M.empty() ? 0 : static_cast<int>(M[0].size()))
+    {
+        for (int i = 0; i < rows_; ++i) {
+            if (static_cast<int>(M[i].size()) != cols_)
+                throw std::invalid_argument("Wiersze macierzy maja rozne dlugosci");
+            std::copy(M[i].begin(), M[i].end(), row(i));
+        }
+    }
+
+    DenseMatrix::DenseMatrix(ConstMatrixView v)
+        : DenseMatrix(v.rows(), v.cols())
+    {
+        for (int i = 0; i < rows_; ++i)
+            std::copy(v.row(i), v.row(i) + cols_, row(i));
+    }
+
+    Matrix DenseMatrix::to_matrix() const
+    {
+        Matrix M(rows_);
+        for (int i = 0; i < rows_; ++i)
+            M[i].assign(row(i), row(i) + cols_);
+        return M;
+    }
+
+    Vector gaussian_elimination(ConstMatrixView A, Vector b, bool verbose)
+    {
+        const int n = A.rows();
+        if (n == 0 || A.cols() != n || static_cast<int>(b.size()) != n)
+            throw std::runtime_error("Złe wymiary układu");
+
+        // 1. tworzymy macierz rozszerzoną [A | b] w jednym buforze
+        DenseMatrix M(n, n + 1);
+        for (int i = 0; i < n; ++i) {
+            std::copy(A.row(i), A.row(i) + n, M.row(i));
+            M(i, n) = b[i];
+        }
 
         if (verbose) {
-            std::cout << "Macierz rozszerzona [A|b] - przed eliminacj:\n";
-            print_step(A);
+            std::cout << "Macierz rozszerzona [A|b] - przed eliminacją:\n";
+            print_step(M);
         }
 
         for (int i = 0; i < n; ++i)
         {
             int maxRow = i;
             for (int k = i + 1; k < n; ++k)
-                if (std::fabs(A[k][i]) > std::fabs(A[maxRow][i]))
+                if (std::fabs(M(k, i)) > std::fabs(M(maxRow, i)))
                     maxRow = k;
-            std::swap(A[i], A[maxRow]);
+            if (maxRow != i)
+                std::swap_ranges(M.row(i), M.row(i) + n + 1, M.row(maxRow));
 
-            if (std::fabs(A[i][i]) < 1e-12)
-                throw std::runtime_error("Macierz osobliwa  brak rozwizania");
+            if (std::fabs(M(i, i)) < PIVOT_EPS)
+                throw std::runtime_error("Macierz osobliwa — brak rozwiązania");
 
+            const double* pivotRow = M.row(i);
             for (int k = i + 1; k < n; ++k)
             {
-                double factor = A[k][i] / A[i][i];
-                for (int j = i; j <= n; ++j)
-                    A[k][j] -= factor * A[i][j];
+                double* rowK = M.row(k);
+                double factor = rowK[i] / pivotRow[i];
+                axpy_sub(rowK + i, pivotRow + i, factor, n + 1 - i);
 
                 if (verbose) {
                     std::cout << "Po wyzerowaniu elementu w wierszu "
                         << k << ", kolumnie " << i << ":\n";
-                    print_step(A);
+                    print_step(M);
                 }
             }
         }
@@ -62,13 +267,149 @@ namespace numlab {
         Vector x(n);
         for (int i = n - 1; i >= 0; --i)
         {
-            x[i] = A[i][n];
-            for (int j = i + 1; j < n; ++j)
-                x[i] -= A[i][j] * x[j];
-            x[i] /= A[i][i];
+            const double* rowI = M.row(i);
+            x[i] = (rowI[n] - dot(rowI + i + 1, x.data() + i + 1, n - i - 1)) / rowI[i];
         }
 
         return x;
     }
 
+    Vector gaussian_elimination(const Matrix& A, Vector b, bool verbose)
+    {
+        return gaussian_elimination(DenseMatrix(A), std::move(b), verbose);
+    }
+
+    LUFactorization::LUFactorization(ConstMatrixView A, int blockSize, int threads)
+    {
+        factor(A, blockSize, threads);
+    }
+
+    void LUFactorization::factor(ConstMatrixView A, int blockSize, int threads)
+    {
+        const int n = A.rows();
+        if (n == 0 || A.cols() != n)
+            throw std::runtime_error("Złe wymiary układu");
+        if (blockSize <= 0)
+            throw std::invalid_argument("blockSize <= 0");
+
+        n_ = 0;
+        if (lu_.rows() != n || lu_.cols() != n)
+            lu_ = DenseMatrix(A);                           // nowy rozmiar - jedyna alokacja
+        else if (A.data() != lu_.data())
+            for (int i = 0; i < n; ++i)                     // ten sam rozmiar - bufor ponownie
+                std::copy(A.row(i), A.row(i) + n, lu_.row(i));
+        piv_.assign(n, 0);
+
+        // przy małych n narzut synchronizacji przewyższa zysk
+        const int nThreads = n >= PARALLEL_MIN_N ? detail::resolve_threads(threads) : 1;
+        detail::SharedPool pool(nThreads);
+
+        for (int k0 = 0; k0 < n; k0 += blockSize) {
+            const int kb = std::min(blockSize, n - k0);
+            lu_panel(lu_, piv_, k0, kb);
+            if (k0 + kb < n) {
+                lu_trsm_upper(lu_, k0, kb);
+                // wiersze podmacierzy są niezależne - każdy wątek dostaje pas wierszy
+                pool.parallel_for(k0 + kb, n, ROW_GRAIN, [&](int r0, int r1) {
+                    lu_update_rows(lu_, k0, kb, r0, r1);
+                });
+            }
+        }
+        n_ = n;
+    }
+
+    Vector LUFactorization::solve(Vector b) const
+    {
+        if (!factored())
+            throw std::runtime_error("Brak rozkładu LU - najpierw factor()");
+        if (static_cast<int>(b.size()) != n_)
+            throw std::runtime_error("Złe wymiary układu");
+        solve_inplace(b.data());
+        return b;
+    }
+
+    void LUFactorization::solve_inplace(double* b) const
+    {
+        if (!factored())
+            throw std::runtime_error("Brak rozkładu LU - najpierw factor()");
+
+        for (int i = 0; i < n_; ++i)
+            if (piv_[i] != i) std::swap(b[i], b[piv_[i]]);
+
+        for (int i = 1; i < n_; ++i)
+            b[i] -= dot(lu_.row(i), b, i);
+        for (int i = n_ - 1; i >= 0; --i) {
+            const double* rowI = lu_.row(i);
+            b[i] = (b[i] - dot(rowI + i + 1, b + i + 1, n_ - i - 1)) / rowI[i];
+        }
+    }
+
+    DenseMatrix LUFactorization::solve_many(ConstMatrixView B) const
+    {
+        if (!factored())
+            throw std::runtime_error("Brak rozkładu LU - najpierw factor()");
+        if (B.rows() != n_)
+            throw std::runtime_error("Złe wymiary układu");
+
+        const int m = B.cols();
+        DenseMatrix X(B);
+        for (int i = 0; i < n_; ++i)
+            if (piv_[i] != i)
+                std::swap_ranges(X.row(i), X.row(i) + m, X.row(piv_[i]));
+
+        // podstawienia wykonujemy na całych wierszach X - wszystkie prawe strony naraz
+        for (int i = 1; i < n_; ++i) {
+            const double* rowI = lu_.row(i);
+            for (int j = 0; j < i; ++j)
+                axpy_sub(X.row(i), X.row(j), rowI[j], m);
+        }
+        for (int i = n_ - 1; i >= 0; --i) {
+            const double* rowI = lu_.row(i);
+            double* xi = X.row(i);
+            for (int j = i + 1; j < n_; ++j)
+                axpy_sub(xi, X.row(j), rowI[j], m);
+            const double inv = 1.0 / rowI[i];
+            for (int c = 0; c < m; ++c)
+                xi[c] *= inv;
+        }
+        return X;
+    }
+
+    int solve_batched(int n, int count, double* A, double* b,
+        BatchLayout layout, int threads, int* info)
+    {
+        if (n <= 0 || count < 0 || (count > 0 && (!A || !b)))
+            throw std::invalid_argument("Niepoprawne parametry paczki układów");
+
+        std::atomic<int> nBad{ 0 };
+        const int grain = layout == BatchLayout::Interleaved ? BATCH_LANES : BATCH_GRAIN;
+        detail::SharedPool pool(count > grain ? detail::resolve_threads(threads) : 1);
+
+        if (layout == BatchLayout::Packed) {
+            const std::ptrdiff_t nn = static_cast<std::ptrdiff_t>(n) * n;
+            pool.parallel_for(0, count, grain, [&](int s0, int s1) {
+                int bad = 0;
+                for (int s = s0; s < s1; ++s) {
+                    double* bs = b + static_cast<std::ptrdiff_t>(s) * n;
+                    const bool ok = solve_small_inplace(n, A + s * nn, bs);
+                    if (!ok) {
+                        ++bad;
+                        std::fill(bs, bs + n, std::numeric_limits<double>::quiet_NaN());
+                    }
+                    if (info) info[s] = ok ? 0 : 1;
+                }
+                nBad += bad;
+            });
+        }
+        else {
+            pool.parallel_for(0, count, grain, [&](int s0, int s1) {
+                for (int c = s0; c < s1; c += BATCH_LANES) {
+                    const int w = std::min(BATCH_LANES, s1 - c);
+                    nBad += solve_lanes_interleaved(n, count, A + c, b + c, w, info ? info + c : nullptr);
+                }
+            });
+        }
+        return nBad;
+    }
+
 } 
@@ -1,6 +1,8 @@
 ﻿#include "nlsolve.h"
 #include <cmath>
+#include <algorithm>
 #include <limits>
+#include <utility>
 
 namespace numlab {
 
@@ -66,4 +68,153 @@ namespace numlab {
         return x0;
     }
 
-} 
+    namespace {
+
+        // Wspólny początek metod z przedziałem: f(a), f(b), kontrola znaku.
+        // false - wynik już ustalony (zły przedział albo pierwiastek na końcu).
+        bool start_bracket(const std::function<double(double)>& f, double a, double b,
+            double& fa, double& fb, RootResult& r)
+        {
+            fa = f(a); fb = f(b);
+            r.evaluations = 2;
+            if (!std::isfinite(fa) || !std::isfinite(fb) || fa * fb > 0) {
+                r.status = RootStatus::BadBracket;
+                return false;
+            }
+            if (fa == 0.0 || fb == 0.0) {
+                r.root = fa == 0.0 ? a : b;
+                r.status = RootStatus::Converged;
+                return false;
+            }
+            return true;
+        }
+
+    }
+
+    RootResult root_brent(const std::function<double(double)>& f,
+        double a, double b, double eps, int maxIter,
+        std::vector<IterData>* trace)
+    {
+        RootResult r;
+        double fa, fb;
+        if (!start_bracket(f, a, b, fa, fb, r)) return r;
+
+        double c = b, fc = fb, d = b - a, e = d;
+        for (int k = 0; ; ++k) {
+            if ((fb > 0) == (fc > 0)) { c = a; fc = fa; d = e = b - a; }
+            if (std::fabs(fc) < std::fabs(fb)) {                     // b - najlepsze przybliżenie
+                a = b; b = c; c = a;
+                fa = fb; fb = fc; fc = fa;
+            }
+            const double tol = 2 * std::numeric_limits<double>::epsilon() * std::fabs(b) + 0.5 * eps;
+            const double xm = 0.5 * (c - b);
+            r.root = b;
+            r.iterations = k;
+            if (std::fabs(xm) <= tol || fb == 0.0) { r.status = RootStatus::Converged; return r; }
+            if (k == maxIter) return r;
+
+            if (std::fabs(e) >= tol && std::fabs(fa) > std::fabs(fb)) {
+                const double s = fb / fa;
+                double p, q;
+                if (a == c) {                                        // sieczna
+                    p = 2 * xm * s;
+                    q = 1 - s;
+                }
+                else {                                               // odwrotna interpolacja kwadratowa
+                    const double qq = fa / fc, rr = fb / fc;
+                    p = s * (2 * xm * qq * (qq - rr) - (b - a) * (rr - 1));
+                    q = (qq - 1) * (rr - 1) * (s - 1);
+                }
+                if (p > 0) q = -q;
+                p = std::fabs(p);
+                if (2 * p < std::min(3 * xm * q - std::fabs(tol * q), std::fabs(e * q))) { e = d; d = p / q; }
+                else { d = xm; e = d; }                              // bisekcja
+            }
+            else { d = xm; e = d; }
+            a = b; fa = fb;
+            b += std::fabs(d) > tol ? d : (xm > 0 ? tol : -tol);
+            fb = f(b);
+            ++r.evaluations;
+            if (trace) trace->push_back({ k + 1,b });
+            if (!std::isfinite(fb)) { r.root = b; r.iterations = k + 1; r.status = RootStatus::NotFinite; return r; }
+        }
+    }
+
+    RootResult root_itp(const std::function<double(double)>& f,
+        double a, double b, double eps, int maxIter,
+        std::vector<IterData>* trace)
+    {
+        RootResult r;
+        double fa, fb;
+        if (!start_bracket(f, a, b, fa, fb, r)) return r;
+        if (a > b) { std::swap(a, b); std::swap(fa, fb); }
+        const double sgn = fa < 0 ? 1.0 : -1.0;                     // sgn*f rośnie na [a, b]
+        fa *= sgn; fb *= sgn;
+
+        // eps <= 0 (lub NaN) -> dolne ograniczenie: odstęp sąsiednich liczb przy końcach,
+        // inaczej log2 niżej daje +inf / NaN, a rzutowanie na int jest UB
+        eps = std::max({ std::numeric_limits<double>::min(),
+                         std::numeric_limits<double>::epsilon() * std::max(std::fabs(a), std::fabs(b)), eps });
+        const double k1 = 0.2 / (b - a), k2 = 2.0;
+        const int n0 = 1;
+        const int nHalf = std::max(0, static_cast<int>(std::ceil(std::log2((b - a) / (2 * eps)))));
+        const int nMax = nHalf + n0;
+
+        for (int j = 0; ; ++j) {
+            r.iterations = j;
+            if (b - a <= 2 * eps) { r.root = 0.5 * (a + b); r.status = RootStatus::Converged; return r; }
+            if (j == maxIter) { r.root = 0.5 * (a + b); return r; }
+
+            const double xHalf = 0.5 * (a + b);
+            const double rad = eps * std::ldexp(1.0, nMax - j) - 0.5 * (b - a);
+            const double delta = k1 * std::pow(b - a, k2);
+            const double xf = (fb * a - fa * b) / (fb - fa);           // interpolacja (regula falsi)
+            const double sigma = xHalf >= xf ? 1.0 : -1.0;
+            const double xt = delta <= std::fabs(xHalf - xf) ? xf + sigma * delta : xHalf;   // obcięcie
+            const double x = std::fabs(xt - xHalf) <= rad ? xt : xHalf - sigma * rad;         // rzut
+
+            const double fx = sgn * f(x);
+            ++r.evaluations;
+            if (trace) trace->push_back({ j + 1,x });
+            if (!std::isfinite(fx)) { r.root = x; r.iterations = j + 1; r.status = RootStatus::NotFinite; return r; }
+            if (fx > 0) { b = x; fb = fx; }
+            else if (fx < 0) { a = x; fa = fx; }
+            else { r.root = x; r.iterations = j + 1; r.status = RootStatus::Converged; return r; }
+        }
+    }
+
+    RootResult root_illinois(const std::function<double(double)>& f,
+        double a, double b, double eps, int maxIter,
+        std::vector<IterData>* trace)
+    {
+        RootResult r;
+        double fa, fb;
+        if (!start_bracket(f, a, b, fa, fb, r)) return r;
+
+        int side = 0;                       // który koniec zmienił się ostatnio: -1 a, +1 b
+        double x = a;
+        for (int k = 1; k <= maxIter; ++k) {
+            x = (a * fb - b * fa) / (fb - fa);
+            const double fx = f(x);
+            ++r.evaluations;
+            if (trace) trace->push_back({ k,x });
+            r.root = x;
+            r.iterations = k;
+            if (!std::isfinite(fx)) { r.status = RootStatus::NotFinite; return r; }
+            if (fx == 0.0) { r.status = RootStatus::Converged; return r; }
+            if ((fx > 0) == (fb > 0)) {
+                b = x; fb = fx;
+                if (side == 1) fa *= 0.5;
+                side = 1;
+            }
+            else {
+                a = x; fa = fx;
+                if (side == -1) fb *= 0.5;
+                side = -1;
+            }
+            if (std::fabs(b - a) <= 2 * eps) { r.status = RootStatus::Converged; return r; }
+        }
+        return r;
+    }
+
+}
@@ -0,0 +1,218 @@
+﻿#include "nlsolve.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace numlab {
+
+    namespace {
+
+        constexpr int ROOT_LANES = 256;     // równania w porcji iterowanej razem
+
+        // Pamięć robocza porcji: dwa punkty z wartościami, nowy punkt, maska aktywnych
+        struct RootBlock {
+            std::vector<double> buf;
+            std::vector<unsigned char> active;
+            double *a, *b, *fa, *fb, *c, *fc;
+
+            RootBlock() : buf(6 * ROOT_LANES), active(ROOT_LANES)
+            {
+                a = buf.data(); b = a + ROOT_LANES; fa = b + ROOT_LANES;
+                fb = fa + ROOT_LANES; c = fb + ROOT_LANES; fc = c + ROOT_LANES;
+            }
+        };
+
+        RootBatchResult make_result(std::size_t n)
+        {
+            RootBatchResult r;
+            r.root.assign(n, std::numeric_limits<double>::quiet_NaN());
+            r.iterations.assign(n, 0);
+            r.status.assign(n, RootStatus::MaxIter);
+            return r;
+        }
+
+        // Porcje po ROOT_LANES równań na wątkach; solve(B, first, m) liczy jedną porcję.
+        template<class Solve>
+        void for_blocks(std::size_t n, int threads, Solve solve)
+        {
+            if (n > static_cast<std::size_t>(std::numeric_limits<int>::max()))
+                throw std::invalid_argument("za dużo równań");
+            const int count = static_cast<int>(n);
+            const int nBlocks = (count + ROOT_LANES - 1) / ROOT_LANES;
+            detail::SharedPool pool(nBlocks > 1 ? detail::resolve_threads(threads) : 1);
+            pool.parallel_for(0, nBlocks, 1, [&](int b0, int b1) {
+                RootBlock B;
+                for (int blk = b0; blk < b1; ++blk) {
+                    const int first = blk * ROOT_LANES;
+                    solve(B, first, std::min(ROOT_LANES, count - first));
+                }
+            });
+        }
+
+        void check_sizes(const std::vector<double>& a, const std::vector<double>& b, int maxIter)
+        {
+            if (a.size() != b.size()) throw std::invalid_argument("Różne rozmiary wektorów");
+            if (maxIter < 1) throw std::invalid_argument("maxIter < 1");
+        }
+
+        // Wspólna część bisekcji i regula falsi: różnią się tylko wyborem punktu c.
+        template<class Point>
+        RootBatchResult bracketed_batch(const RootBatchFunction& f,
+            const std::vector<double>& a, const std::vector<double>& b,
+            double eps, int maxIter, int threads, bool stopOnWidth, Point point)
+        {
+            check_sizes(a, b, maxIter);
+            RootBatchResult res = make_result(a.size());
+            for_blocks(a.size(), threads, [&](RootBlock& B, int first, int m) {
+                std::copy_n(a.data() + first, m, B.a);
+                std::copy_n(b.data() + first, m, B.b);
+                f(B.a, B.fa, first, m);
+                f(B.b, B.fb, first, m);
+                int left = 0;
+                for (int k = 0; k < m; ++k) {           // jak start_bracket w nlsolve.cpp
+                    const bool ok = std::isfinite(B.fa[k]) && std::isfinite(B.fb[k]) && B.fa[k] * B.fb[k] <= 0.0;
+                    const bool atEnd = ok && (B.fa[k] == 0.0 || B.fb[k] == 0.0);
+                    B.active[k] = ok && !atEnd;
+                    left += B.active[k];
+                    if (!ok) res.status[first + k] = RootStatus::BadBracket;
+                    if (atEnd) {
+                        res.root[first + k] = B.fa[k] == 0.0 ? B.a[k] : B.b[k];
+                        res.status[first + k] = RootStatus::Converged;
+                    }
+                    B.c[k] = B.a[k];
+                }
+                for (int it = 1; it <= maxIter && left > 0; ++it) {
+                    for (int k = 0; k < m; ++k)
+                        B.c[k] = B.active[k] ? point(B.a[k], B.b[k], B.fa[k], B.fb[k]) : B.c[k];
+                    f(B.c, B.fc, first, m);
+                    double* root = res.root.data() + first;
+                    int* iters = res.iterations.data() + first;
+                    RootStatus* status = res.status.data() + first;
+                    int done = 0;
+                    for (int k = 0; k < m; ++k) {          // bez skoków - pętla wektoryzowalna
+                        const double c = B.c[k], fc = B.fc[k];
+                        const bool act = B.active[k] != 0;
+                        const bool bad = act && !std::isfinite(fc);
+                        const bool conv = act && !bad
+                            && (fc == 0.0 || std::fabs(fc) < eps || (stopOnWidth && 0.5 * (B.b[k] - B.a[k]) < eps));
+                        const bool stop = bad || conv;
+                        const bool lower = act && !stop && B.fa[k] * fc < 0.0;
+                        const bool upper = act && !stop && !lower;
+                        root[k] = stop ? c : root[k];
+                        iters[k] = stop ? it : iters[k];
+                        status[k] = conv ? RootStatus::Converged : bad ? RootStatus::NotFinite : status[k];
+                        B.b[k] = lower ? c : B.b[k];  B.fb[k] = lower ? fc : B.fb[k];
+                        B.a[k] = upper ? c : B.a[k];  B.fa[k] = upper ? fc : B.fa[k];
+                        B.active[k] = act && !stop;
+                        done += stop;
+                    }
+                    left -= done;
+                }
+                for (int k = 0; k < m; ++k)
+                    if (B.active[k]) {
+                        res.root[first + k] = stopOnWidth ? 0.5 * (B.a[k] + B.b[k]) : B.c[k];
+                        res.iterations[first + k] = maxIter;
+                    }
+            });
+            return res;
+        }
+
+    }
+
+    std::size_t RootBatchResult::converged() const
+    {
+        return static_cast<std::size_t>(std::count(status.begin(), status.end(), RootStatus::Converged));
+    }
+
+    RootBatchResult root_bisection_batch(const RootBatchFunction& f,
+        const std::vector<double>& a, const std::vector<double>& b,
+        double eps, int maxIter, int threads)
+    {
+        return bracketed_batch(f, a, b, eps, maxIter, threads, true,
+            [](double lo, double hi, double, double) { return 0.5 * (lo + hi); });
+    }
+
+    RootBatchResult root_regulafalsi_batch(const RootBatchFunction& f,
+        const std::vector<double>& a, const std::vector<double>& b,
+        double eps, int maxIter, int threads)
+    {
+        return bracketed_batch(f, a, b, eps, maxIter, threads, false,
+            [](double lo, double hi, double flo, double fhi) { return (lo * fhi - hi * flo) / (fhi - flo); });
+    }
+
+    RootBatchResult root_secant_batch(const RootBatchFunction& f,
+        const std::vector<double>& x0, const std::vector<double>& x1,
+        double eps, int maxIter, int threads)
+    {
+        check_sizes(x0, x1, maxIter);
+        RootBatchResult res = make_result(x0.size());
+        for_blocks(x0.size(), threads, [&](RootBlock& B, int first, int m) {
+            double *p0 = B.a, *p1 = B.b, *f0 = B.fa, *f1 = B.fb;
+            std::copy_n(x0.data() + first, m, p0);
+            std::copy_n(x1.data() + first, m, p1);
+            f(p0, f0, first, m);
+            f(p1, f1, first, m);
+            std::fill_n(B.active.begin(), m, 1);
+            int left = m;
+            auto finish = [&](int k, double x, int it, RootStatus s) {
+                res.root[first + k] = x;
+                res.iterations[first + k] = it;
+                res.status[first + k] = s;
+                B.active[k] = 0;
+                --left;
+            };
+            for (int it = 1; it <= maxIter && left > 0; ++it) {
+                for (int k = 0; k < m; ++k) {
+                    if (!B.active[k]) continue;
+                    if (std::fabs(f1[k] - f0[k]) < 1e-14) { finish(k, p1[k], it - 1, RootStatus::Stalled); continue; }
+                    const double x2 = p1[k] - f1[k] * (p1[k] - p0[k]) / (f1[k] - f0[k]);
+                    if (!std::isfinite(x2)) { finish(k, x2, it, RootStatus::NotFinite); continue; }
+                    if (std::fabs(x2 - p1[k]) < eps) { finish(k, x2, it, RootStatus::Converged); continue; }
+                    p0[k] = p1[k]; f0[k] = f1[k]; p1[k] = x2;
+                }
+                if (left > 0) f(p1, f1, first, m);
+            }
+            for (int k = 0; k < m; ++k)
+                if (B.active[k]) { res.root[first + k] = p1[k]; res.iterations[first + k] = maxIter; }
+        });
+        return res;
+    }
+
+    RootBatchResult root_newton_batch(const RootBatchDerivative& fdf,
+        const std::vector<double>& x0,
+        double eps, int maxIter, int threads)
+    {
+        check_sizes(x0, x0, maxIter);
+        RootBatchResult res = make_result(x0.size());
+        for_blocks(x0.size(), threads, [&](RootBlock& B, int first, int m) {
+            double *x = B.a, *fx = B.fa, *dfx = B.fb;
+            std::copy_n(x0.data() + first, m, x);
+            std::fill_n(B.active.begin(), m, 1);
+            int left = m;
+            auto finish = [&](int k, double r, int it, RootStatus s) {
+                res.root[first + k] = r;
+                res.iterations[first + k] = it;
+                res.status[first + k] = s;
+                B.active[k] = 0;
+                --left;
+            };
+            for (int it = 1; it <= maxIter && left > 0; ++it) {
+                fdf(x, fx, dfx, first, m);
+                for (int k = 0; k < m; ++k) {
+                    if (!B.active[k]) continue;
+                    if (std::fabs(dfx[k]) < 1e-14) { finish(k, x[k], it - 1, RootStatus::Stalled); continue; }
+                    const double x1 = x[k] - fx[k] / dfx[k];
+                    if (!std::isfinite(x1)) { finish(k, x1, it, RootStatus::NotFinite); continue; }
+                    if (std::fabs(x1 - x[k]) < eps) { finish(k, x1, it, RootStatus::Converged); continue; }
+                    x[k] = x1;
+                }
+            }
+            for (int k = 0; k < m; ++k)
+                if (B.active[k]) { res.root[first + k] = x[k]; res.iterations[first + k] = maxIter; }
+        });
+        return res;
+    }
+
+}
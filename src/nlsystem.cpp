@@ -0,0 +1,194 @@
+﻿#include "nlsolve.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace numlab {
+
+    namespace {
+
+        constexpr double ARMIJO = 1e-4;
+        constexpr double LAMBDA_MIN = 1e-10;
+
+        double norm_inf(const double* v, int n)
+        {
+            double m = 0.0;
+            for (int i = 0; i < n; ++i) m = std::max(m, std::fabs(v[i]));
+            return m;
+        }
+
+        double half_sq(const double* v, int n)
+        {
+            double s = 0.0;
+            for (int i = 0; i < n; ++i) s += v[i] * v[i];
+            return 0.5 * s;
+        }
+
+        bool all_finite(const double* v, int n)
+        {
+            for (int i = 0; i < n; ++i) if (!std::isfinite(v[i])) return false;
+            return true;
+        }
+
+    }
+
+    void SystemWorkspace::resize(int size)
+    {
+        if (size <= 0) throw std::invalid_argument("n <= 0");
+        if (size == n) return;
+        n = size;
+        J = DenseMatrix(n, n);
+        H = DenseMatrix();
+        buf.assign(static_cast<std::size_t>(6) * n, 0.0);
+    }
+
+    SystemResult root_system(const SystemFunction& F, std::vector<double>& x,
+        const SystemOptions& opt, SystemWorkspace* ws)
+    {
+        if (x.empty()) throw std::invalid_argument("pusty wektor x");
+        if (opt.maxIter < 1) throw std::invalid_argument("maxIter < 1");
+        const int n = static_cast<int>(x.size());
+        SystemWorkspace local;
+        SystemWorkspace& w = ws ? *ws : local;
+        w.resize(n);
+        const bool broyden = opt.method == SystemMethod::Broyden;
+        if (broyden && w.H.rows() != n) w.H = DenseMatrix(n, n);
+
+        double* fx = w.buf.data();
+        double* fnew = fx + n;
+        double* dx = fnew + n;
+        double* xnew = dx + n;
+        double* tmp = xnew + n;
+        double* row = tmp + n;
+
+        SystemResult r;
+        auto eval = [&](const double* xx, double* out) { F(xx, out); ++r.evaluations; };
+
+        // J w x (fx = F(x)); false - J osobliwe
+        auto refresh = [&]() {
+            ++r.jacobians;
+            if (opt.jacobian) opt.jacobian(x.data(), w.J.data());
+            else {
+                const double sq = std::sqrt(std::numeric_limits<double>::epsilon());
+                std::copy(x.begin(), x.end(), xnew);
+                for (int j = 0; j < n; ++j) {
+                    const double h = sq * std::max(std::fabs(x[j]), 1.0);
+                    xnew[j] = x[j] + h;
+                    eval(xnew, tmp);
+                    xnew[j] = x[j];
+                    for (int i = 0; i < n; ++i) w.J(i, j) = (tmp[i] - fx[i]) / h;
+                }
+            }
+            try { w.lu.factor(w.J.view(), LUFactorization::DEFAULT_BLOCK, opt.threads); }
+            catch (const std::runtime_error&) { return false; }
+            if (broyden)                                            // H = J^-1 kolumnami
+                for (int j = 0; j < n; ++j) {
+                    std::fill(tmp, tmp + n, 0.0);
+                    tmp[j] = 1.0;
+                    w.lu.solve_inplace(tmp);
+                    for (int i = 0; i < n; ++i) w.H(i, j) = tmp[i];
+                }
+            return true;
+        };
+
+        eval(x.data(), fx);
+        r.residual = norm_inf(fx, n);
+        if (!all_finite(fx, n)) { r.status = RootStatus::NotFinite; return r; }
+        if (r.residual <= opt.tol) { r.status = RootStatus::Converged; return r; }
+
+        bool needJac = true, fresh = false;
+        for (int it = 1; it <= opt.maxIter; ++it) {
+            r.iterations = it;
+            if (needJac) {
+                if (!refresh()) { r.status = RootStatus::Stalled; return r; }
+                needJac = false;
+                fresh = true;
+            }
+
+            // kierunek: dx = -J^-1 F  (Broyden: -H F)
+            if (broyden)
+                for (int i = 0; i < n; ++i) {
+                    const double* h = w.H.row(i);
+                    double s = 0.0;
+                    for (int j = 0; j < n; ++j) s += h[j] * fx[j];
+                    dx[i] = -s;
+                }
+            else {
+                for (int i = 0; i < n; ++i) dx[i] = -fx[i];
+                w.lu.solve_inplace(dx);
+            }
+
+            // nawrót: phi(l) = 0.5||F(x + l dx)||^2, phi'(0) = -2 phi(0) dla kierunku Newtona
+            const double phi0 = half_sq(fx, n), slope = -2.0 * phi0;
+            double lambda = 1.0;
+            bool accepted = false;
+            for (;;) {
+                for (int i = 0; i < n; ++i) xnew[i] = x[i] + lambda * dx[i];
+                eval(xnew, fnew);
+                const double phi = all_finite(fnew, n) ? half_sq(fnew, n) : std::numeric_limits<double>::infinity();
+                if (!opt.lineSearch || phi <= phi0 + ARMIJO * lambda * slope) { accepted = true; break; }
+                if (lambda < LAMBDA_MIN) break;
+                const double q = std::isfinite(phi) ? -slope * lambda * lambda / (2.0 * (phi - phi0 - slope * lambda)) : 0.0;
+                lambda = std::max(0.1 * lambda, std::min(0.5 * lambda, q));
+            }
+            if (!accepted) {
+                if (!fresh) { needJac = true; continue; }          // Broyden: restart z nowym J
+                r.status = RootStatus::Stalled;
+                return r;
+            }
+            if (!all_finite(fnew, n)) { r.status = RootStatus::NotFinite; return r; }
+
+            double stepMax = 0.0, xMax = 0.0;
+            for (int i = 0; i < n; ++i) {
+                dx[i] = xnew[i] - x[i];                              // s
+                stepMax = std::max(stepMax, std::fabs(dx[i]));
+                xMax = std::max(xMax, std::fabs(xnew[i]));
+            }
+
+            if (broyden) {
+                // "dobra" aktualizacja Broydena odwrotności:
+                // H += (s - H y) (s^T H) / (s^T H y),  y = F_new - F
+                for (int i = 0; i < n; ++i) fx[i] = fnew[i] - fx[i];   // y (fx odtworzone niżej)
+                double denom = 0.0;
+                for (int i = 0; i < n; ++i) {
+                    const double* h = w.H.row(i);
+                    double s = 0.0;
+                    for (int j = 0; j < n; ++j) s += h[j] * fx[j];
+                    tmp[i] = dx[i] - s;                              // s - H y
+                    denom += dx[i] * s;
+                }
+                std::fill(row, row + n, 0.0);
+                for (int i = 0; i < n; ++i) {                        // s^T H
+                    const double* h = w.H.row(i);
+                    for (int j = 0; j < n; ++j) row[j] += dx[i] * h[j];
+                }
+                if (std::fabs(denom) > std::numeric_limits<double>::epsilon() * stepMax * stepMax) {
+                    for (int i = 0; i < n; ++i) {
+                        double* h = w.H.row(i);
+                        const double u = tmp[i] / denom;
+                        for (int j = 0; j < n; ++j) h[j] += u * row[j];
+                    }
+                }
+                else needJac = true;
+            }
+            else needJac = true;
+
+            std::copy(xnew, xnew + n, x.begin());
+            std::copy(fnew, fnew + n, fx);
+            const bool stepFresh = fresh;
+            fresh = false;
+            r.residual = norm_inf(fx, n);
+            if (r.residual <= opt.tol) { r.status = RootStatus::Converged; return r; }
+            if (stepMax <= opt.stepTol * (1.0 + xMax)) {
+                // krok znikomy, a residuum > tol: x przestał się zmieniać, ale to nie pierwiastek
+                // (minimum lokalne ||F|| albo stare H w Broydenie - wtedy jeszcze restart z nowym J)
+                if (!stepFresh) { needJac = true; continue; }
+                r.status = RootStatus::Stalled;
+                return r;
+            }
+        }
+        return r;
+    }
+
+}
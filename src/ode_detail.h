@@ -0,0 +1,97 @@
+﻿#pragma once
+#include "differential.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <stdexcept>
+
+// Wspólne elementy całkowania adaptacyjnego ODE (differential.cpp, ode_stiff.cpp).
+
+namespace numlab {
+namespace detail {
+
+    // Interpolacja wewnątrz ostatniego przyjętego kroku (gęste wyjście).
+    class DenseStep {
+    public:
+        virtual void eval(double t, double* y) const = 0;     // t z [t0, t1] kroku
+    protected:
+        ~DenseStep() = default;
+    };
+
+    // Hermite sześcienny z wartości i pochodnych na obu końcach kroku (rząd 3)
+    class HermiteDense final : public DenseStep {
+    public:
+        HermiteDense(int n, double t0, double t1,
+            const double* y0, const double* f0, const double* y1, const double* f1)
+            : n_(n), t0_(t0), h_(t1 - t0), y0_(y0), f0_(f0), y1_(y1), f1_(f1) {}
+
+        void eval(double t, double* y) const override
+        {
+            const double s = (t - t0_) / h_, s1 = 1.0 - s;
+            const double h00 = (1.0 + 2.0 * s) * s1 * s1, h10 = s * s1 * s1 * h_;
+            const double h01 = s * s * (3.0 - 2.0 * s), h11 = -s * s * s1 * h_;
+            for (int i = 0; i < n_; ++i)
+                y[i] = h00 * y0_[i] + h10 * f0_[i] + h01 * y1_[i] + h11 * f1_[i];
+        }
+
+    private:
+        int n_;
+        double t0_, h_;
+        const double *y0_, *f0_, *y1_, *f1_;
+    };
+
+    // Wołane po każdym przyjętym kroku ze stanem na jego końcu (przed nadpisaniem
+    // stanu początkowego kroku, więc dense może z niego korzystać); dla t0 dense == nullptr.
+    // false - zatrzymaj całkowanie (zdarzenie terminalne), solver kończy z success = true.
+    using OdeEmit = std::function<bool(double t, const double* y, const DenseStep* dense)>;
+
+    inline void check_ode_args(double t0, double tEnd, const OdeOptions& opt)
+    {
+        if (!(tEnd > t0)) throw std::invalid_argument("tEnd <= t0");
+        if (opt.absTol <= 0.0 && opt.relTol <= 0.0) throw std::invalid_argument("tolerancja <= 0");
+        if (opt.absTol < 0.0 || opt.relTol < 0.0) throw std::invalid_argument("tolerancja < 0");
+    }
+
+    // ||v / (absTol + relTol*max(|y|,|z|))||_RMS
+    inline double scaled_norm(int n, const double* v, const double* y, const double* z, const OdeOptions& opt)
+    {
+        double s = 0.0;
+        for (int i = 0; i < n; ++i) {
+            const double sc = opt.absTol + opt.relTol * std::max(std::fabs(y[i]), std::fabs(z[i]));
+            const double r = v[i] / sc;
+            s += r * r;
+        }
+        return std::sqrt(s / n);
+    }
+
+    // Dobór h0 jak w Hairer/Nørsett/Wanner (II.4): skala z |y0|, |f0| i jednego kroku Eulera;
+    // q - rząd estymatora błędu (wykładnik 1/(q+1)).
+    template<class Rhs>
+    double initial_step(Rhs& rhs, int n, double t, const double* y, const double* f0,
+        double span, int q, const OdeOptions& opt, double* ytmp, double* ftmp, OdeStats& st)
+    {
+        const double d0 = scaled_norm(n, y, y, y, opt), d1 = scaled_norm(n, f0, y, y, opt);
+        double h0 = (d0 < 1e-5 || d1 < 1e-5) ? 1e-6 : 0.01 * d0 / d1;
+        h0 = std::min(h0, span);
+        for (int i = 0; i < n; ++i) ytmp[i] = y[i] + h0 * f0[i];
+        rhs(t + h0, static_cast<const double*>(ytmp), ftmp);
+        ++st.evaluations;
+        for (int i = 0; i < n; ++i) ftmp[i] -= f0[i];
+        const double d2 = scaled_norm(n, ftmp, y, y, opt) / h0;
+        const double h1 = std::max(d1, d2) <= 1e-15
+            ? std::max(1e-6, h0 * 1e-3)
+            : std::pow(0.01 / std::max(d1, d2), 1.0 / (q + 1));
+        return std::min(100 * h0, h1);
+    }
+
+    inline bool is_stiff(OdeMethod m)
+    {
+        return m == OdeMethod::Rosenbrock23 || m == OdeMethod::RadauIIA5 || m == OdeMethod::BDF;
+    }
+
+    // Metody sztywne (ode_stiff.cpp); argumenty już sprawdzone przez check_ode_args.
+    void ode_stiff(const OdeSystemRHS& f, int n, double* y,
+        double t0, double tEnd, const OdeOptions& opt, OdeStats& st, const OdeEmit& emit);
+
+}
+}
@@ -0,0 +1,124 @@
+﻿#include "differential.h"
+#include "parallel.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace numlab {
+
+    namespace {
+
+        constexpr int ENS_LANES = 64;     // trajektorie w bloku (= stride stanu bloku)
+
+        // Pamięć robocza jednego bloku: stan, 4 etapy, stan pośredni, maska aktywnych
+        struct EnsembleBlock {
+            int    dim;
+            Vector buf;
+            double *y, *k1, *k2, *k3, *k4, *yt, *mask;
+
+            explicit EnsembleBlock(int d)
+                : dim(d), buf(static_cast<std::size_t>(6 * d + 1) * ENS_LANES)
+            {
+                const std::size_t sz = static_cast<std::size_t>(d) * ENS_LANES;
+                y = buf.data(); k1 = y + sz; k2 = k1 + sz; k3 = k2 + sz; k4 = k3 + sz; yt = k4 + sz;
+                mask = yt + sz;
+            }
+        };
+
+        // Jeden krok RK4 dla bloku; trajektorie zatrzymane (mask = 0) nie zmieniają stanu,
+        // nawet gdy f zwraca dla nich NaN/Inf.
+        void rk4_block(EnsembleBlock& B, const OdeEnsembleRHS& f, double t, double h, int first, int m)
+        {
+            const int L = ENS_LANES, n = B.dim * L;
+            double* y = B.y; double* yt = B.yt; const double* mask = B.mask;
+            double* k1 = B.k1; double* k2 = B.k2; double* k3 = B.k3; double* k4 = B.k4;
+
+            f(t, y, k1, first, m, L);
+            for (int j = 0; j < n; ++j) yt[j] = y[j] + 0.5 * h * k1[j];
+            f(t + 0.5 * h, yt, k2, first, m, L);
+            for (int j = 0; j < n; ++j) yt[j] = y[j] + 0.5 * h * k2[j];
+            f(t + 0.5 * h, yt, k3, first, m, L);
+            for (int j = 0; j < n; ++j) yt[j] = y[j] + h * k3[j];
+            f(t + h, yt, k4, first, m, L);
+            const double h6 = h / 6.0;
+            for (int i = 0; i < B.dim; ++i) {
+                double* yi = y + i * L;
+                const double *a = k1 + i * L, *b = k2 + i * L, *c = k3 + i * L, *d = k4 + i * L;
+                for (int k = 0; k < L; ++k)          // wybór, nie mnożenie: 0 * NaN = NaN
+                    yi[k] = mask[k] != 0.0 ? yi[k] + h6 * (a[k] + 2.0 * b[k] + 2.0 * c[k] + d[k]) : yi[k];
+            }
+        }
+
+    }
+
+    EnsembleResult
+        ode_solve_ensemble(int count, int dim, const Vector& y0,
+            double t0, double tEnd, double h,
+            const OdeEnsembleRHS& f, const EnsembleOptions& opt)
+    {
+        if (count <= 0 || dim <= 0) throw std::invalid_argument("count <= 0 lub dim <= 0");
+        if (y0.size() != static_cast<std::size_t>(count) * dim) throw std::invalid_argument("Zły rozmiar y0");
+        if (!(h > 0.0)) throw std::invalid_argument("h <= 0");
+        if (!(tEnd > t0)) throw std::invalid_argument("tEnd <= t0");
+        if (opt.saveEvery <= 0) throw std::invalid_argument("saveEvery <= 0");
+
+        const long long N = static_cast<long long>((tEnd - t0) / h + 1e-9);
+        const bool tail = t0 + N * h < tEnd - 1e-12;
+
+        EnsembleResult res;
+        res.count = count;
+        res.dim = dim;
+        for (long long s = 0; s <= N; s += opt.saveEvery) res.t.push_back(t0 + s * h);
+        if (N % opt.saveEvery != 0 || tail) res.t.push_back(tail ? tEnd : t0 + N * h);
+        const std::size_t S = res.t.size();
+        res.y.resize(S * dim * count);
+        res.tStop.assign(count, tEnd);
+        res.stopped.assign(count, 0);
+
+        const int nBlocks = (count + ENS_LANES - 1) / ENS_LANES;
+        detail::SharedPool pool(nBlocks > 1 ? detail::resolve_threads(opt.threads) : 1);
+        pool.parallel_for(0, nBlocks, 1, [&](int b0, int b1) {
+            EnsembleBlock B(dim);
+            for (int blk = b0; blk < b1; ++blk) {
+                const int first = blk * ENS_LANES, m = std::min(ENS_LANES, count - first);
+                std::fill(B.buf.begin(), B.buf.end(), 0.0);
+                for (int i = 0; i < dim; ++i)
+                    std::copy_n(y0.data() + static_cast<std::size_t>(i) * count + first, m, B.y + i * ENS_LANES);
+                for (int k = 0; k < m; ++k) B.mask[k] = 1.0;
+                int active = m;
+
+                std::size_t s = 0;
+                auto save = [&]() {
+                    for (int i = 0; i < dim; ++i)
+                        std::copy_n(B.y + i * ENS_LANES, m, res.y.data() + (s * dim + i) * count + first);
+                    ++s;
+                };
+                auto check_stop = [&](double t) {
+                    if (!opt.stop) return;
+                    for (int k = 0; k < m; ++k)
+                        if (B.mask[k] != 0.0 && opt.stop(first + k, t, B.y + k, ENS_LANES)) {
+                            B.mask[k] = 0.0;
+                            res.stopped[first + k] = 1;
+                            res.tStop[first + k] = t;
+                            --active;
+                        }
+                };
+
+                check_stop(t0);
+                save();
+                for (long long i = 0; i < N; ++i) {
+                    if (active > 0) rk4_block(B, f, t0 + i * h, h, first, m);
+                    check_stop(t0 + (i + 1) * h);
+                    if ((i + 1) % opt.saveEvery == 0 || (i + 1 == N && !tail)) save();
+                }
+                if (tail) {
+                    const double t = t0 + N * h;
+                    if (active > 0) rk4_block(B, f, t, tEnd - t, first, m);
+                    check_stop(tEnd);
+                    save();
+                }
+            }
+        });
+        return res;
+    }
+
+}
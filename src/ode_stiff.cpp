@@ -0,0 +1,667 @@
+﻿#include "ode_detail.h"
+#include "linsolve.h"
+#include <complex>
+#include <limits>
+#include <vector>
+
+namespace numlab {
+namespace detail {
+
+    namespace {
+
+        constexpr double EPS = std::numeric_limits<double>::epsilon();
+        constexpr double SAFETY = 0.9;
+        constexpr double FAC_MIN = 0.2, FAC_MAX = 10.0;
+
+        // f, J i liczniki wspólne dla wszystkich metod sztywnych
+        struct StiffContext {
+            const OdeSystemRHS& f;
+            int                 n;
+            const OdeOptions&   opt;
+            OdeStats&           st;
+            Vector              yw, fw;     // robocze dla różnicowego J
+
+            StiffContext(const OdeSystemRHS& f_, int n_, const OdeOptions& o, OdeStats& s)
+                : f(f_), n(n_), opt(o), st(s), yw(n_), fw(n_) {}
+
+            void rhs(double t, const double* y, double* dy)
+            {
+                f(t, y, dy);
+                ++st.evaluations;
+            }
+
+            // J(t,y); f0 = f(t,y) jeśli znane (różnice skończone), inaczej nullptr
+            void jacobian(double t, const double* y, const double* f0, double* J)
+            {
+                ++st.jacobians;
+                if (opt.jacobian) { opt.jacobian(t, y, J); return; }
+
+                Vector f0buf;
+                if (!f0) { f0buf.resize(n); rhs(t, y, f0buf.data()); f0 = f0buf.data(); }
+                std::copy(y, y + n, yw.begin());
+                for (int j = 0; j < n; ++j) {
+                    const double yj = yw[j];
+                    yw[j] = yj + std::sqrt(EPS) * std::max(std::fabs(yj), 1.0);
+                    const double d = yw[j] - yj;                 // dokładnie reprezentowalny przyrost
+                    rhs(t, yw.data(), fw.data());
+                    for (int i = 0; i < n; ++i) J[i * n + j] = (fw[i] - f0[i]) / d;
+                    yw[j] = yj;
+                }
+            }
+
+            // LU(diag*I - c*J); false gdy macierz osobliwa
+            bool factor(DenseMatrix& M, LUFactorization& lu, double diag, double c, const double* J)
+            {
+                for (int i = 0; i < n; ++i)
+                    for (int j = 0; j < n; ++j)
+                        M(i, j) = (i == j ? diag : 0.0) - c * J[i * n + j];
+                ++st.factorizations;
+                try { lu.factor(M.view()); }
+                catch (const std::runtime_error&) { return false; }
+                return true;
+            }
+
+            // false: wyczerpany budżet kroków albo h poniżej minimum
+            bool can_step(double t, double h) const
+            {
+                if (st.accepted + st.rejected >= opt.maxSteps) return false;
+                return h >= std::max(opt.hMin, 16 * EPS * std::fabs(t));
+            }
+
+            // ||v / (absTol + relTol*|y|)||_RMS
+            double norm(const double* v, const double* y) const { return scaled_norm(n, v, y, y, opt); }
+        };
+
+        double newton_tol(const OdeOptions& opt)
+        {
+            return opt.relTol > 0.0 ? std::max(10 * EPS / opt.relTol, std::min(0.03, std::sqrt(opt.relTol))) : 0.03;
+        }
+
+        bool all_finite(const double* v, int n)
+        {
+            for (int i = 0; i < n; ++i)
+                if (!std::isfinite(v[i])) return false;
+            return true;
+        }
+
+        /* ---- Rosenbrock 2(3), W-metoda (Shampine & Reichelt, ode23s) ----------------- */
+        // Rząd 2 zachowany także dla przybliżonego J, więc J jest używane przez kilka kroków;
+        // dopuszczalny wiek J rośnie po udanych krokach ze starym J i maleje o połowę po
+        // odrzuceniu (wtedy J liczone od nowa). W = I - h*d*J rozkładane tylko przy zmianie h
+        // (h nie zmienia się, gdy sterownik proponuje współczynnik z [1, 1.2]).
+        constexpr int ROS_JAC_MAX_AGE = 20;
+
+        void rosenbrock23(StiffContext& c, double* y, double t, double tEnd, const OdeEmit& emit)
+        {
+            const int n = c.n;
+            const OdeOptions& opt = c.opt;
+            const double d = 1.0 / (2.0 + std::sqrt(2.0)), e32 = 6.0 + std::sqrt(2.0);
+
+            Vector J(static_cast<std::size_t>(n) * n), F0(n), F1(n), F2(n), T(n),
+                k1(n), k2(n), k3(n), ynew(n), tmp(n), err(n);
+            DenseMatrix W(n, n);
+            LUFactorization lu;
+
+            c.rhs(t, y, F0.data());
+            emit(t, y, nullptr);
+            auto rhs = [&c](double tt, const double* yy, double* dy) { c.f(tt, yy, dy); };
+            double h = opt.h0 > 0.0 ? opt.h0
+                : initial_step(rhs, n, t, y, F0.data(), tEnd - t, 2, opt, tmp.data(), err.data(), c.st);
+            h = std::min(h, opt.hMax);
+
+            c.jacobian(t, y, F0.data(), J.data());
+            int jacAge = 0, jacMaxAge = ROS_JAC_MAX_AGE;
+            double hLU = 0.0;          // h, dla którego W jest rozłożone (0 - brak)
+            bool needT = true;
+
+            while (t < tEnd) {
+                if (!c.can_step(t, h)) return;
+                bool last = false;
+                if (t + h >= tEnd) { h = tEnd - t; last = true; }
+
+                if (needT) {                                        // T = df/dt różnicowo
+                    const double dt = std::sqrt(EPS) * std::max(std::fabs(t), std::fabs(h));
+                    c.rhs(t + dt, y, tmp.data());
+                    for (int i = 0; i < n; ++i) T[i] = (tmp[i] - F0[i]) / dt;
+                    needT = false;
+                }
+                if (h != hLU) {
+                    if (!c.factor(W, lu, 1.0, h * d, J.data())) {
+                        ++c.st.rejected;
+                        h *= 0.5;
+                        hLU = 0.0;
+                        continue;
+                    }
+                    hLU = h;
+                }
+
+                for (int i = 0; i < n; ++i) k1[i] = F0[i] + h * d * T[i];
+                lu.solve_inplace(k1.data());
+                for (int i = 0; i < n; ++i) tmp[i] = y[i] + 0.5 * h * k1[i];
+                c.rhs(t + 0.5 * h, tmp.data(), F1.data());
+                for (int i = 0; i < n; ++i) k2[i] = F1[i] - k1[i];
+                lu.solve_inplace(k2.data());
+                for (int i = 0; i < n; ++i) {
+                    k2[i] += k1[i];
+                    ynew[i] = y[i] + h * k2[i];
+                }
+                c.rhs(t + h, ynew.data(), F2.data());
+                for (int i = 0; i < n; ++i)
+                    k3[i] = F2[i] - e32 * (k2[i] - F1[i]) - 2.0 * (k1[i] - F0[i]) + h * d * T[i];
+                lu.solve_inplace(k3.data());
+                for (int i = 0; i < n; ++i) err[i] = h / 6.0 * (k1[i] - 2.0 * k2[i] + k3[i]);
+
+                const double e = all_finite(ynew.data(), n)
+                    ? scaled_norm(n, err.data(), y, ynew.data(), opt)
+                    : std::numeric_limits<double>::infinity();
+
+                if (e <= 1.0) {
+                    ++c.st.accepted;
+                    const double tNew = last ? tEnd : t + h;
+                    const HermiteDense dense(n, t, tNew, y, F0.data(), ynew.data(), F2.data());
+                    if (!emit(tNew, ynew.data(), &dense)) { c.st.success = true; return; }
+                    t = tNew;
+                    std::copy(ynew.begin(), ynew.end(), y);
+                    F0.swap(F2);                                    // f(t+h, y_new) już policzone
+                    needT = true;
+                    if (jacAge > 0) jacMaxAge = std::min(ROS_JAC_MAX_AGE, jacMaxAge + 1);
+                    if (++jacAge >= jacMaxAge) {
+                        c.jacobian(t, y, F0.data(), J.data());
+                        jacAge = 0;
+                        hLU = 0.0;
+                    }
+                    double fac = e > 0.0 ? SAFETY * std::pow(e, -1.0 / 3.0) : FAC_MAX;
+                    fac = std::min(FAC_MAX, std::max(FAC_MIN, fac));
+                    if (fac >= 1.0 && fac <= 1.2) fac = 1.0;         // zachowaj rozkład W
+                    h = std::min(h * fac, opt.hMax);
+                }
+                else {
+                    ++c.st.rejected;
+                    if (jacAge > 0) {
+                        c.jacobian(t, y, F0.data(), J.data());
+                        jacAge = 0;
+                        jacMaxAge = std::max(1, jacMaxAge / 2);
+                    }
+                    h *= std::isfinite(e) ? std::max(FAC_MIN, SAFETY * std::pow(e, -1.0 / 3.0)) : FAC_MIN;
+                    hLU = 0.0;
+                }
+            }
+            c.st.success = true;
+        }
+
+        /* ---- Radau IIA, 3 etapy, rząd 5 ------------------------------------------- */
+        // Układ etapów (I - h A⊗J) przekształcony macierzą T z rozkładu własnego A^-1
+        // (RADAU5, Hairer & Wanner): jedna rzeczywista macierz n x n (mu/h) I - J i jedna
+        // zespolona ((alfa + i beta)/h) I - J zamiast 3n x 3n. Uproszczony Newton używa
+        // obu rozkładów przez wiele kroków; rzeczywisty służy też estymatorowi błędu.
+        // J liczone od nowa tylko przy wolnej zbieżności Newtona albo jej braku.
+        constexpr int RADAU_NEWTON_MAX = 6;
+
+        using Cplx = std::complex<double>;
+
+        // LU z częściowym wyborem dla alpha*I - J (zespolone alpha, rzeczywiste J)
+        class ComplexLU {
+        public:
+            explicit ComplexLU(int n) : n_(n), a_(static_cast<std::size_t>(n) * n), piv_(n) {}
+
+            // false gdy macierz osobliwa
+            bool factor(Cplx alpha, const double* J)
+            {
+                const int n = n_;
+                for (int i = 0; i < n; ++i)
+                    for (int j = 0; j < n; ++j)
+                        a_[i * n + j] = (i == j ? alpha : Cplx(0.0)) - J[i * n + j];
+                for (int k = 0; k < n; ++k) {
+                    int p = k;
+                    double best = std::norm(a_[k * n + k]);
+                    for (int i = k + 1; i < n; ++i)
+                        if (std::norm(a_[i * n + k]) > best) { best = std::norm(a_[i * n + k]); p = i; }
+                    if (best == 0.0) return false;
+                    piv_[k] = p;
+                    if (p != k) std::swap_ranges(a_.begin() + k * n, a_.begin() + (k + 1) * n, a_.begin() + p * n);
+                    const Cplx inv = 1.0 / a_[k * n + k];
+                    const Cplx* rowK = a_.data() + k * n;
+                    for (int i = k + 1; i < n; ++i) {
+                        Cplx* rowI = a_.data() + i * n;
+                        const Cplx l = rowI[k] *= inv;
+                        for (int j = k + 1; j < n; ++j) rowI[j] -= l * rowK[j];
+                    }
+                }
+                return true;
+            }
+
+            void solve_inplace(Cplx* b) const
+            {
+                const int n = n_;
+                for (int k = 0; k < n; ++k)
+                    if (piv_[k] != k) std::swap(b[k], b[piv_[k]]);
+                for (int i = 1; i < n; ++i) {
+                    Cplx s = b[i];
+                    for (int j = 0; j < i; ++j) s -= a_[i * n + j] * b[j];
+                    b[i] = s;
+                }
+                for (int i = n - 1; i >= 0; --i) {
+                    Cplx s = b[i];
+                    for (int j = i + 1; j < n; ++j) s -= a_[i * n + j] * b[j];
+                    b[i] = s / a_[i * n + i];
+                }
+            }
+
+        private:
+            int n_;
+            std::vector<Cplx> a_;
+            std::vector<int> piv_;
+        };
+
+        void radau_iia5(StiffContext& c, double* y, double t, double tEnd, const OdeEmit& emit)
+        {
+            const int n = c.n, n3 = 3 * n;
+            const OdeOptions& opt = c.opt;
+            const double s6 = std::sqrt(6.0);
+            const double C[3] = { (4.0 - s6) / 10.0, (4.0 + s6) / 10.0, 1.0 };
+            const double E[3] = { (-13.0 - 7.0 * s6) / 3.0, (-13.0 + 7.0 * s6) / 3.0, -1.0 / 3.0 };
+            // wartości własne A^-1: MU oraz MU_C i sprzężona; Z = T W, W = TI Z
+            const double MU = 3.0 + std::cbrt(9.0) - std::cbrt(3.0);
+            const Cplx MU_C(3.0 + 0.5 * (std::cbrt(3.0) - std::cbrt(9.0)),
+                -0.5 * (std::pow(3.0, 5.0 / 6.0) + std::pow(3.0, 7.0 / 6.0)));
+            const double T[3][3] = {
+                { 0.09443876248897524, -0.14125529502095421, 0.03002919410514742 },
+                { 0.25021312296533332, 0.20412935229379994, -0.38294211275726192 },
+                { 1.0, 1.0, 0.0 } };
+            const double TI[3][3] = {
+                { 4.17871859155190428, 0.32768282076106237, 0.52337644549944951 },
+                { -4.17871859155190428, -0.32768282076106237, 0.47662355450055044 },
+                { 0.50287263494578682, -2.57192694985560522, 0.59603920482822492 } };
+            const double tol = newton_tol(opt);
+
+            Vector J(static_cast<std::size_t>(n) * n), f0(n), Z(n3), W(n3), F(n3), dW(n3),
+                ytmp(n), ynew(n), err(n), ze(n), tmp(n);
+            std::vector<Cplx> dWc(n);
+            DenseMatrix We(n, n);
+            LUFactorization luE;
+            ComplexLU luC(n);
+
+            c.rhs(t, y, f0.data());
+            emit(t, y, nullptr);
+            auto rhs = [&c](double tt, const double* yy, double* dy) { c.f(tt, yy, dy); };
+            double h = opt.h0 > 0.0 ? opt.h0
+                : initial_step(rhs, n, t, y, f0.data(), tEnd - t, 3, opt, ytmp.data(), tmp.data(), c.st);
+            h = std::min(h, opt.hMax);
+
+            c.jacobian(t, y, f0.data(), J.data());
+            bool currentJac = true, lastRejected = false;
+            double hLU = 0.0, hOld = 0.0, errOld = 0.0;
+
+            auto predict = [](double hh, double hOld_, double e, double eOld) {
+                if (e == 0.0) return FAC_MAX;
+                const double mult = (eOld > 0.0 && hOld_ > 0.0) ? hh / hOld_ * std::pow(eOld / e, 0.25) : 1.0;
+                return std::min(1.0, mult) * std::pow(e, -0.25);
+            };
+
+            while (t < tEnd) {
+                if (!c.can_step(t, h)) return;
+                bool last = false;
+                if (t + h >= tEnd) { h = tEnd - t; last = true; }
+
+                if (h != hLU) {
+                    bool ok = c.factor(We, luE, MU / h, 1.0, J.data());
+                    ++c.st.factorizations;
+                    ok = ok && luC.factor(MU_C / h, J.data());
+                    if (!ok) {
+                        ++c.st.rejected;
+                        h *= 0.5;
+                        hLU = 0.0;
+                        continue;
+                    }
+                    hLU = h;
+                }
+
+                // uproszczony Newton dla przyrostów etapów Z_s = Y_s - y w zmiennych W = TI Z:
+                // (MU/h I - J) dW_0 = (TI F)_0 - MU/h W_0,  (MU_C/h I - J) dW_c = (TI F)_c - MU_C/h W_c
+                std::fill(Z.begin(), Z.end(), 0.0);
+                std::fill(W.begin(), W.end(), 0.0);
+                const double mr = MU / h;
+                const Cplx mc = MU_C / h;
+                bool converged = false;
+                int nIter = 0;
+                double rate = -1.0, dOld = -1.0;
+                for (int k = 0; k < RADAU_NEWTON_MAX; ++k) {
+                    nIter = k + 1;
+                    for (int s = 0; s < 3; ++s) {
+                        for (int i = 0; i < n; ++i) ytmp[i] = y[i] + Z[s * n + i];
+                        c.rhs(t + C[s] * h, ytmp.data(), F.data() + s * n);
+                    }
+                    if (!all_finite(F.data(), n3)) break;
+                    for (int i = 0; i < n; ++i) {
+                        const double f1 = F[i], f2 = F[n + i], f3 = F[2 * n + i];
+                        dW[i] = TI[0][0] * f1 + TI[0][1] * f2 + TI[0][2] * f3 - mr * W[i];
+                        dWc[i] = Cplx(TI[1][0] * f1 + TI[1][1] * f2 + TI[1][2] * f3,
+                            TI[2][0] * f1 + TI[2][1] * f2 + TI[2][2] * f3) - mc * Cplx(W[n + i], W[2 * n + i]);
+                    }
+                    luE.solve_inplace(dW.data());
+                    luC.solve_inplace(dWc.data());
+                    for (int i = 0; i < n; ++i) { dW[n + i] = dWc[i].real(); dW[2 * n + i] = dWc[i].imag(); }
+                    double dn = 0.0;
+                    for (int s = 0; s < 3; ++s) {
+                        const double b = c.norm(dW.data() + s * n, y);
+                        dn += b * b;
+                    }
+                    dn = std::sqrt(dn / 3.0);
+                    if (dOld >= 0.0) rate = dn / dOld;
+                    if (rate >= 0.0 && (rate >= 1.0
+                        || std::pow(rate, RADAU_NEWTON_MAX - k) / (1.0 - rate) * dn > tol)) break;
+                    for (int i = 0; i < n3; ++i) W[i] += dW[i];
+                    for (int s = 0; s < 3; ++s)
+                        for (int i = 0; i < n; ++i)
+                            Z[s * n + i] = T[s][0] * W[i] + T[s][1] * W[n + i] + T[s][2] * W[2 * n + i];
+                    if (dn == 0.0 || (rate >= 0.0 && rate / (1.0 - rate) * dn < tol)) { converged = true; break; }
+                    dOld = dn;
+                }
+
+                if (!converged) {
+                    ++c.st.rejected;
+                    if (!currentJac) {                              // najpierw świeże J przy tym samym h
+                        c.jacobian(t, y, f0.data(), J.data());
+                        currentJac = true;
+                    }
+                    else {
+                        h *= 0.5;
+                    }
+                    hLU = 0.0;
+                    continue;
+                }
+
+                for (int i = 0; i < n; ++i) {
+                    ynew[i] = y[i] + Z[2 * n + i];
+                    ze[i] = (E[0] * Z[i] + E[1] * Z[n + i] + E[2] * Z[2 * n + i]) / h;
+                    err[i] = f0[i] + ze[i];
+                }
+                luE.solve_inplace(err.data());
+                double e = scaled_norm(n, err.data(), y, ynew.data(), opt);
+                if (e > 1.0 && lastRejected) {                      // estymator "wygładzony" (Hairer-Wanner)
+                    for (int i = 0; i < n; ++i) ytmp[i] = y[i] + err[i];
+                    c.rhs(t, ytmp.data(), tmp.data());
+                    for (int i = 0; i < n; ++i) err[i] = tmp[i] + ze[i];
+                    luE.solve_inplace(err.data());
+                    e = scaled_norm(n, err.data(), y, ynew.data(), opt);
+                }
+                const double safety = SAFETY * (2 * RADAU_NEWTON_MAX + 1) / (2 * RADAU_NEWTON_MAX + nIter);
+
+                if (e > 1.0) {
+                    ++c.st.rejected;
+                    h *= std::max(FAC_MIN, safety * predict(h, hOld, e, errOld));
+                    hLU = 0.0;
+                    lastRejected = true;
+                    continue;
+                }
+
+                ++c.st.accepted;
+                const bool recomputeJac = nIter > 2 && rate > 1e-3;
+                double fac = std::min(FAC_MAX, safety * predict(h, hOld, e, errOld));
+                if (!recomputeJac && fac < 1.2) fac = 1.0;          // zachowaj oba rozkłady
+                const double tNew = last ? tEnd : t + h;
+                c.rhs(tNew, ynew.data(), tmp.data());
+                {
+                    const HermiteDense dense(n, t, tNew, y, f0.data(), ynew.data(), tmp.data());
+                    if (!emit(tNew, ynew.data(), &dense)) { c.st.success = true; return; }
+                }
+                t = tNew;
+                std::copy(ynew.begin(), ynew.end(), y);
+                f0.swap(tmp);
+                if (recomputeJac) {
+                    c.jacobian(t, y, f0.data(), J.data());
+                    hLU = 0.0;
+                }
+                currentJac = recomputeJac;
+                hOld = h;
+                errOld = e;
+                h = std::min(h * fac, opt.hMax);
+                lastRejected = false;
+            }
+            c.st.success = true;
+        }
+
+        /* ---- BDF rzędu 1..5, zmienny krok i rząd ---------------------------------- */
+        // Postać z różnicami wstecznymi D (Shampine & Reichelt, ode15s; jak solve_ivp BDF):
+        // zmiana kroku przelicza D macierzą R(ratio)·U, Newton z macierzą I - h/alpha_k J.
+        // Rozkład jest używany dopóki h się nie zmieni, J - dopóki Newton się zbiega.
+        constexpr int BDF_MAX_ORDER = 5;
+        constexpr int BDF_NEWTON_MAX = 4;
+
+        // R[i][j] = prod_{k=1..i} (k - 1 - factor*j) / k,  R[0][j] = 1
+        void bdf_compute_R(int order, double factor, double R[6][6])
+        {
+            for (int j = 0; j <= order; ++j) R[0][j] = 1.0;
+            for (int i = 1; i <= order; ++i) {
+                R[i][0] = 0.0;
+                for (int j = 1; j <= order; ++j)
+                    R[i][j] = R[i - 1][j] * (i - 1 - factor * j) / i;
+            }
+        }
+
+        // D[0..order] <- (R U)^T D[0..order], tmp - bufor (order+1)*n
+        void bdf_change_D(double* D, int n, int order, double factor, double* tmp)
+        {
+            double R[6][6], U[6][6], RU[6][6];
+            bdf_compute_R(order, factor, R);
+            bdf_compute_R(order, 1.0, U);
+            for (int i = 0; i <= order; ++i)
+                for (int j = 0; j <= order; ++j) {
+                    double s = 0.0;
+                    for (int k = 0; k <= order; ++k) s += R[i][k] * U[k][j];
+                    RU[i][j] = s;
+                }
+            for (int i = 0; i <= order; ++i)
+                for (int m = 0; m < n; ++m) {
+                    double s = 0.0;
+                    for (int k = 0; k <= order; ++k) s += RU[k][i] * D[k * n + m];
+                    tmp[i * n + m] = s;
+                }
+            std::copy(tmp, tmp + (order + 1) * n, D);
+        }
+
+        // Gęste wyjście BDF: wielomian interpolacyjny zapisany w różnicach D
+        // (po aktualizacji D[0] = y_new), jak BdfDenseOutput w scipy.
+        class BdfDense final : public DenseStep {
+        public:
+            BdfDense(int n, int order, double t, double h, const double* D)
+                : n_(n), order_(order), t_(t), h_(h), D_(D) {}
+
+            void eval(double tt, double* y) const override
+            {
+                std::copy(D_, D_ + n_, y);
+                double p = 1.0;
+                for (int j = 0; j < order_; ++j) {
+                    p *= (tt - (t_ - h_ * j)) / (h_ * (j + 1));
+                    const double* Dj = D_ + static_cast<std::ptrdiff_t>(j + 1) * n_;
+                    for (int i = 0; i < n_; ++i) y[i] += p * Dj[i];
+                }
+            }
+
+        private:
+            int n_, order_;
+            double t_, h_;
+            const double* D_;
+        };
+
+        void bdf(StiffContext& c, double* y, double t, double tEnd, const OdeEmit& emit)
+        {
+            const int n = c.n;
+            const OdeOptions& opt = c.opt;
+            const double tol = newton_tol(opt);
+
+            double gamma[BDF_MAX_ORDER + 1], errConst[BDF_MAX_ORDER + 2];
+            gamma[0] = 0.0;
+            for (int k = 1; k <= BDF_MAX_ORDER; ++k) gamma[k] = gamma[k - 1] + 1.0 / k;
+            for (int k = 0; k <= BDF_MAX_ORDER + 1; ++k) errConst[k] = 1.0 / (k + 1);
+            const double* alpha = gamma;                          // BDF: kappa = 0
+
+            Vector D(static_cast<std::size_t>(BDF_MAX_ORDER + 3) * n), tmpD(static_cast<std::size_t>(BDF_MAX_ORDER + 1) * n);
+            Vector J(static_cast<std::size_t>(n) * n), f0(n), ypred(n), ynew(n), psi(n), d(n),
+                dy(n), fw(n), scale(n), err(n), tmp(n);
+            DenseMatrix W(n, n);
+            LUFactorization lu;
+            auto row = [&D, n](int k) { return D.data() + static_cast<std::ptrdiff_t>(k) * n; };
+
+            c.rhs(t, y, f0.data());
+            emit(t, y, nullptr);
+            auto rhs = [&c](double tt, const double* yy, double* dy_) { c.f(tt, yy, dy_); };
+            double h = opt.h0 > 0.0 ? opt.h0
+                : initial_step(rhs, n, t, y, f0.data(), tEnd - t, 1, opt, tmp.data(), err.data(), c.st);
+            h = std::min(h, opt.hMax);
+
+            std::copy(y, y + n, row(0));
+            for (int i = 0; i < n; ++i) row(1)[i] = h * f0[i];
+            c.jacobian(t, y, f0.data(), J.data());
+            bool currentJac = true;
+            double cLU = 0.0;                 // c = h/alpha, dla którego W jest rozłożone
+            int order = 1, nEqual = 0;
+
+            auto rms = [&](const double* v, double k) {
+                double s = 0.0;
+                for (int i = 0; i < n; ++i) { const double r = k * v[i] / scale[i]; s += r * r; }
+                return std::sqrt(s / n);
+            };
+
+            while (t < tEnd) {
+                if (h > opt.hMax) {
+                    bdf_change_D(D.data(), n, order, opt.hMax / h, tmpD.data());
+                    h = opt.hMax;
+                    nEqual = 0;
+                }
+                if (!c.can_step(t, h)) return;
+                bool last = false;
+                if (t + h >= tEnd) {
+                    const double hn = tEnd - t;
+                    if (hn != h) {
+                        bdf_change_D(D.data(), n, order, hn / h, tmpD.data());
+                        nEqual = 0;
+                    }
+                    h = hn;
+                    last = true;
+                }
+                const double tNew = last ? tEnd : t + h;
+
+                std::fill(ypred.begin(), ypred.end(), 0.0);
+                std::fill(psi.begin(), psi.end(), 0.0);
+                for (int k = 0; k <= order; ++k)
+                    for (int i = 0; i < n; ++i) ypred[i] += row(k)[i];
+                for (int k = 1; k <= order; ++k)
+                    for (int i = 0; i < n; ++i) psi[i] += gamma[k] * row(k)[i];
+                for (int i = 0; i < n; ++i) {
+                    psi[i] /= alpha[order];
+                    scale[i] = opt.absTol + opt.relTol * std::fabs(ypred[i]);
+                }
+                const double cc = h / alpha[order];
+
+                bool converged = false;
+                int nIter = 0;
+                for (;;) {
+                    bool factored = true;
+                    if (cc != cLU) {
+                        factored = c.factor(W, lu, 1.0, cc, J.data());
+                        cLU = factored ? cc : 0.0;
+                    }
+                    if (factored) {
+                        // Newton: y = ypred + d,  d = c*f(tNew, y) - psi
+                        std::fill(d.begin(), d.end(), 0.0);
+                        std::copy(ypred.begin(), ypred.end(), ynew.begin());
+                        double dyOld = -1.0;
+                        for (int k = 0; k < BDF_NEWTON_MAX; ++k) {
+                            nIter = k + 1;
+                            c.rhs(tNew, ynew.data(), fw.data());
+                            if (!all_finite(fw.data(), n)) break;
+                            for (int i = 0; i < n; ++i) dy[i] = cc * fw[i] - psi[i] - d[i];
+                            lu.solve_inplace(dy.data());
+                            const double dn = rms(dy.data(), 1.0);
+                            const double rate = dyOld >= 0.0 ? dn / dyOld : -1.0;
+                            if (rate >= 0.0 && (rate >= 1.0
+                                || std::pow(rate, BDF_NEWTON_MAX - k) / (1.0 - rate) * dn > tol)) break;
+                            for (int i = 0; i < n; ++i) { ynew[i] += dy[i]; d[i] += dy[i]; }
+                            if (dn == 0.0 || (rate >= 0.0 && rate / (1.0 - rate) * dn < tol)) { converged = true; break; }
+                            dyOld = dn;
+                        }
+                    }
+                    if (converged || currentJac) break;
+                    c.jacobian(tNew, ypred.data(), nullptr, J.data());
+                    currentJac = true;
+                    cLU = 0.0;
+                }
+
+                if (!converged) {
+                    ++c.st.rejected;
+                    bdf_change_D(D.data(), n, order, 0.5, tmpD.data());
+                    h *= 0.5;
+                    nEqual = 0;
+                    cLU = 0.0;
+                    continue;
+                }
+
+                const double safety = SAFETY * (2 * BDF_NEWTON_MAX + 1) / (2 * BDF_NEWTON_MAX + nIter);
+                for (int i = 0; i < n; ++i) scale[i] = opt.absTol + opt.relTol * std::fabs(ynew[i]);
+                const double e = rms(d.data(), errConst[order]);
+                if (e > 1.0) {
+                    ++c.st.rejected;
+                    const double fac = std::max(FAC_MIN, safety * std::pow(e, -1.0 / (order + 1)));
+                    bdf_change_D(D.data(), n, order, fac, tmpD.data());
+                    h *= fac;
+                    nEqual = 0;
+                    continue;                                       // nowe h -> cc != cLU, W rozkładane od nowa; J bez zmian
+                }
+
+                ++c.st.accepted;
+                ++nEqual;
+                t = tNew;
+                std::copy(ynew.begin(), ynew.end(), y);
+                currentJac = false;
+
+                for (int i = 0; i < n; ++i) {
+                    row(order + 2)[i] = d[i] - row(order + 1)[i];
+                    row(order + 1)[i] = d[i];
+                }
+                for (int k = order; k >= 0; --k)
+                    for (int i = 0; i < n; ++i) row(k)[i] += row(k + 1)[i];
+                {
+                    const BdfDense dense(n, order, t, h, D.data());
+                    if (!emit(t, y, &dense)) { c.st.success = true; return; }
+                }
+
+                if (nEqual < order + 1) continue;
+
+                // wybór rzędu: k-1, k, k+1 - ten, który pozwala na najdłuższy krok
+                const double inf = std::numeric_limits<double>::infinity();
+                const double norms[3] = {
+                    order > 1 ? rms(row(order), errConst[order - 1]) : inf,
+                    e,
+                    order < BDF_MAX_ORDER ? rms(row(order + 2), errConst[order + 1]) : inf };
+                int best = 0;
+                double bestFac = 0.0;
+                for (int j = 0; j < 3; ++j) {
+                    const double fj = norms[j] == 0.0 ? inf : std::pow(norms[j], -1.0 / (order + j));
+                    if (fj > bestFac) { bestFac = fj; best = j; }
+                }
+                order += best - 1;
+                const double fac = std::min(FAC_MAX, safety * bestFac);
+                bdf_change_D(D.data(), n, order, fac, tmpD.data());
+                h *= fac;
+                nEqual = 0;
+            }
+            c.st.success = true;
+        }
+
+    }
+
+    void ode_stiff(const OdeSystemRHS& f, int n, double* y,
+        double t0, double tEnd, const OdeOptions& opt, OdeStats& st, const OdeEmit& emit)
+    {
+        StiffContext c(f, n, opt, st);
+        switch (opt.method) {
+        case OdeMethod::Rosenbrock23: rosenbrock23(c, y, t0, tEnd, emit); break;
+        case OdeMethod::RadauIIA5:    radau_iia5(c, y, t0, tEnd, emit);   break;
+        case OdeMethod::BDF:          bdf(c, y, t0, tEnd, emit);          break;
+        default: throw std::invalid_argument("Metoda nie jest sztywna");
+        }
+    }
+
+}
+}
@@ -0,0 +1,147 @@
+﻿#include "parallel.h"
+#include <algorithm>
+
+namespace numlab {
+namespace detail {
+
+    namespace {
+
+        // Bezczynne pule; najwyżej MAX_IDLE, nadmiar jest zamykany przy oddaniu.
+        constexpr std::size_t MAX_IDLE = 8;
+
+        struct PoolCache {
+            std::mutex m;
+            std::vector<std::unique_ptr<ThreadPool>> idle;
+        };
+
+        PoolCache& pool_cache()
+        {
+            static PoolCache c;
+            return c;
+        }
+
+    }
+
+    int resolve_threads(int threads)
+    {
+        if (threads > 0) return threads;
+        unsigned hw = std::thread::hardware_concurrency();
+        return hw ? static_cast<int>(hw) : 1;
+    }
+
+    ThreadPool::ThreadPool(int threads)
+    {
+        const int n = resolve_threads(threads);
+        workers_.reserve(n - 1);
+        for (int i = 1; i < n; ++i)
+            workers_.emplace_back([this] { worker_loop(); });
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (auto& w : workers_) w.join();
+    }
+
+    void ThreadPool::parallel_for(int begin, int end, int grain, const Body& body)
+    {
+        if (end <= begin) return;
+        if (grain < 1) grain = 1;
+        if (workers_.empty() || end - begin <= grain) {
+            body(begin, end);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            job_ = &body;
+            next_ = begin;
+            end_ = end;
+            grain_ = grain;
+            error_ = nullptr;
+            pending_ = static_cast<int>(workers_.size());
+            ++generation_;
+        }
+        cv_.notify_all();
+        run_chunks();
+
+        std::unique_lock<std::mutex> lk(m_);
+        done_cv_.wait(lk, [this] { return pending_ == 0; });
+        job_ = nullptr;
+        if (error_) std::rethrow_exception(error_);
+    }
+
+    void ThreadPool::run_chunks()
+    {
+        for (;;) {
+            const int lo = next_.fetch_add(grain_);
+            if (lo >= end_) break;
+            const int hi = std::min(lo + grain_, end_);
+            try {
+                (*job_)(lo, hi);
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lk(m_);
+                if (!error_) error_ = std::current_exception();
+            }
+        }
+    }
+
+    void ThreadPool::worker_loop()
+    {
+        unsigned seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lk(m_);
+                cv_.wait(lk, [&] { return stop_ || generation_ != seen; });
+                if (stop_) return;
+                seen = generation_;
+            }
+            run_chunks();
+            {
+                std::lock_guard<std::mutex> lk(m_);
+                if (--pending_ == 0) done_cv_.notify_one();
+            }
+        }
+    }
+
+    SharedPool::SharedPool(int threads)
+    {
+        const int n = resolve_threads(threads);
+        if (n <= 1) return;
+        PoolCache& c = pool_cache();
+        {
+            std::lock_guard<std::mutex> lk(c.m);
+            for (auto& p : c.idle)
+                if (p->size() == n) {
+                    std::swap(p, c.idle.back());
+                    pool_ = std::move(c.idle.back());
+                    c.idle.pop_back();
+                    return;
+                }
+        }
+        pool_ = std::make_unique<ThreadPool>(n);            // poza blokadą - start wątków
+    }
+
+    SharedPool::~SharedPool()
+    {
+        if (!pool_) return;
+        PoolCache& c = pool_cache();
+        std::unique_ptr<ThreadPool> drop;                    // join poza blokadą
+        std::lock_guard<std::mutex> lk(c.m);
+        if (c.idle.size() < MAX_IDLE) c.idle.push_back(std::move(pool_));
+        else drop = std::move(pool_);
+    }
+
+    void SharedPool::parallel_for(int begin, int end, int grain, const ThreadPool::Body& body)
+    {
+        if (pool_) pool_->parallel_for(begin, end, grain, body);
+        else if (end > begin) body(begin, end);
+    }
+
+}
+}
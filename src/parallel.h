@@ -0,0 +1,70 @@
+﻿#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <exception>
+#include <memory>
+
+// Wewnętrzna pula wątków biblioteki (nie jest częścią publicznego interfejsu).
+
+namespace numlab {
+namespace detail {
+
+    // threads <= 0  ->  liczba wątków sprzętowych
+    int resolve_threads(int threads);
+
+    class ThreadPool {
+    public:
+        using Body = std::function<void(int, int)>;
+
+        explicit ThreadPool(int threads);     // wątek wywołujący też liczy
+        ~ThreadPool();
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        int size() const { return static_cast<int>(workers_.size()) + 1; }
+
+        // Wywołuje body(lo, hi) dla kolejnych porcji [begin, end) o długości grain,
+        // rozdzielanych dynamicznie między wątki. Wraca po przetworzeniu całości;
+        // pierwszy wyjątek z body jest przekazywany dalej.
+        void parallel_for(int begin, int end, int grain, const Body& body);
+
+    private:
+        void worker_loop();
+        void run_chunks();
+
+        std::vector<std::thread> workers_;
+        std::mutex m_;
+        std::condition_variable cv_, done_cv_;
+        const Body* job_ = nullptr;
+        std::atomic<int> next_{ 0 };
+        int end_ = 0, grain_ = 1;
+        int pending_ = 0;
+        unsigned generation_ = 0;
+        bool stop_ = false;
+        std::exception_ptr error_;
+    };
+
+    // Pula wzięta z pamięci podręcznej procesu i oddawana w destruktorze. Pule powstają
+    // leniwie i są używane ponownie, więc kolejne wywołania nie tworzą wątków systemowych;
+    // wywołania współbieżne lub zagnieżdżone dostają osobne pule.
+    // threads == 1 (po resolve_threads) - bez puli, body w wątku wywołującym.
+    class SharedPool {
+    public:
+        explicit SharedPool(int threads);
+        ~SharedPool();
+        SharedPool(const SharedPool&) = delete;
+        SharedPool& operator=(const SharedPool&) = delete;
+
+        int size() const { return pool_ ? pool_->size() : 1; }
+        void parallel_for(int begin, int end, int grain, const ThreadPool::Body& body);
+
+    private:
+        std::unique_ptr<ThreadPool> pool_;
+    };
+
+}
+}
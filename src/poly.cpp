@@ -0,0 +1,204 @@
+﻿#include "poly.h"
+#include "simd.h"
+#include "parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace numlab {
+
+    namespace {
+
+        constexpr int ESTRIN_STACK = 64;    // bufor na stosie wystarcza do stopnia 127
+        constexpr int ROOTS_GRAIN = 16;     // wielomiany w porcji wątku
+
+        // Newton p(z)/p'(z) oraz ograniczenie błędu Hornera; a[n] != 0.
+        // Dla |z| > 1 liczone na q(w) = w^n p(1/w): p/p' = z / (n - w q'(w)/q(w)).
+        // false - |p(z)| na poziomie błędów zaokrągleń (z już jest pierwiastkiem).
+        bool newton_ratio(const double* a, int n, Complex z, Complex& ratio)
+        {
+            const double eps = std::numeric_limits<double>::epsilon();
+            if (std::abs(z) <= 1.0) {
+                Complex p = a[n], dp = 0.0;
+                double bound = std::fabs(a[n]);
+                const double r = std::abs(z);
+                for (int k = n - 1; k >= 0; --k) {
+                    dp = dp * z + p;
+                    p = p * z + a[k];
+                    bound = bound * r + std::fabs(a[k]);
+                }
+                if (std::abs(p) <= eps * bound) return false;
+                ratio = p / dp;
+                return true;
+            }
+            const Complex w = 1.0 / z;
+            Complex q = a[0], dq = 0.0;
+            double bound = std::fabs(a[0]);
+            const double r = std::abs(w);
+            for (int k = 1; k <= n; ++k) {
+                dq = dq * w + q;
+                q = q * w + a[k];
+                bound = bound * r + std::fabs(a[k]);
+            }
+            if (std::abs(q) <= eps * bound) return false;
+            ratio = z / (static_cast<double>(n) - w * dq / q);
+            return true;
+        }
+
+        // Aberth-Ehrlich dla a[0..n], a[0] != 0, a[n] != 0; wynik w z[0..n-1].
+        // done - bufor n bajtów. Zwraca true, gdy wszystkie przybliżenia zbieżne.
+        bool aberth(const double* a, int n, Complex* z, unsigned char* done, int maxIter)
+        {
+            if (n == 1) { z[0] = -a[0] / a[1]; return true; }
+
+            // start: okrąg o środku -a[n-1]/(n a[n]) i promieniu |p(c)/a[n]|^(1/n),
+            // kąty przesunięte, by nie trafiać w symetrię wielomianów rzeczywistych
+            const Complex c = -a[n - 1] / (n * a[n]);
+            Complex pc = a[n];
+            for (int k = n - 1; k >= 0; --k) pc = pc * c + a[k];
+            double rad = std::pow(std::abs(pc / a[n]), 1.0 / n);
+            if (!(rad > 0.0) || !std::isfinite(rad)) rad = 1.0;
+            const double PI = 3.14159265358979323846;
+            for (int k = 0; k < n; ++k) {
+                z[k] = c + std::polar(rad, 2 * PI * k / n + 0.4);
+                done[k] = 0;
+            }
+
+            int left = n;
+            for (int it = 0; it < maxIter && left > 0; ++it) {
+                for (int k = 0; k < n; ++k) {
+                    if (done[k]) continue;
+                    Complex ratio;
+                    if (!newton_ratio(a, n, z[k], ratio)) { done[k] = 1; --left; continue; }
+                    Complex sum = 0.0;
+                    for (int j = 0; j < n; ++j)
+                        if (j != k) sum += 1.0 / (z[k] - z[j]);
+                    const Complex step = ratio / (1.0 - ratio * sum);
+                    z[k] -= step;
+                    if (std::abs(step) <= 2 * std::numeric_limits<double>::epsilon() * std::abs(z[k])) { done[k] = 1; --left; }
+                }
+            }
+            return left == 0;
+        }
+
+        // Pierwiastki wielomianu stopnia (nominalnie) degree; z[degree..]: NaN dla
+        // obniżonego stopnia. false - wielomian zerowy albo brak zbieżności.
+        bool roots_one(const double* a, int degree, Complex* z, unsigned char* done, int maxIter, int& found)
+        {
+            int top = degree;
+            while (top >= 0 && a[top] == 0.0) --top;
+            found = std::max(top, 0);
+            const double nan = std::numeric_limits<double>::quiet_NaN();
+            std::fill(z + found, z + degree, Complex(nan, nan));
+            if (top < 0) return false;
+            int low = 0;
+            while (a[low] == 0.0) ++low;                            // pierwiastki zerowe
+            std::fill(z, z + low, Complex(0.0, 0.0));
+            const bool ok = top == low || aberth(a + low, top - low, z + low, done, maxIter);
+            std::sort(z, z + found, [](const Complex& u, const Complex& v) {
+                return u.real() < v.real() || (u.real() == v.real() && u.imag() < v.imag());
+            });
+            return ok;
+        }
+
+    }
+
+    double poly_estrin(const Vector& a, double x)
+    {
+        const int n = static_cast<int>(a.size());
+        if (n == 0) return 0.0;
+
+        int m = (n + 1) / 2;
+        double stack[ESTRIN_STACK] = {};
+        Vector heap;
+        double* b = stack;
+        if (m > ESTRIN_STACK) { heap.resize(m); b = heap.data(); }
+
+        for (int i = 0; i < m; ++i)
+            b[i] = 2 * i + 1 < n ? a[2 * i] + a[2 * i + 1] * x : a[2 * i];
+
+        // b[i] <- b[2i] + b[2i+1]*x^(2^k); zapis pod i <= 2i nie nadpisuje jeszcze potrzebnych
+        double xp = x * x;
+        while (m > 1) {
+            const int half = (m + 1) / 2;
+            for (int i = 0; i < half; ++i)
+                b[i] = 2 * i + 1 < m ? b[2 * i] + b[2 * i + 1] * xp : b[2 * i];
+            m = half;
+            xp *= xp;
+        }
+        return b[0];
+    }
+
+    void poly_eval_many(const Vector& a, const double* x, double* y, std::size_t n)
+    {
+        detail::simd().horner(a.data(), static_cast<int>(a.size()), x, y,
+            static_cast<std::ptrdiff_t>(n));
+    }
+
+    Vector poly_eval_many(const Vector& a, const Vector& x)
+    {
+        Vector y(x.size());
+        poly_eval_many(a, x.data(), y.data(), x.size());
+        return y;
+    }
+
+    Vector poly_derivative(const Vector& a)
+    {
+        if (a.size() <= 1) return { 0.0 };
+        Vector d(a.size() - 1);
+        for (std::size_t k = 1; k < a.size(); ++k)
+            d[k - 1] = a[k] * static_cast<double>(k);
+        return d;
+    }
+
+    Vector poly_antiderivative(const Vector& a, double c0)
+    {
+        Vector P(a.size() + 1);
+        P[0] = c0;
+        for (std::size_t k = 0; k < a.size(); ++k)
+            P[k + 1] = a[k] / static_cast<double>(k + 1);
+        return P;
+    }
+
+    std::vector<Complex> poly_roots(const Vector& a, int maxIter, bool* converged)
+    {
+        if (maxIter < 1) throw std::invalid_argument("maxIter < 1");
+        const int degree = static_cast<int>(a.size()) - 1;
+        if (degree < 0 || std::all_of(a.begin(), a.end(), [](double v) { return v == 0.0; }))
+            throw std::invalid_argument("wielomian zerowy");
+
+        std::vector<Complex> z(degree);
+        std::vector<unsigned char> done(degree);
+        int found = 0;
+        const bool ok = roots_one(a.data(), degree, z.data(), done.data(), maxIter, found);
+        z.resize(found);
+        if (converged) *converged = ok;
+        return z;
+    }
+
+    int poly_roots_batch(int degree, int count, const double* a, Complex* roots,
+        int threads, int* info)
+    {
+        if (degree < 1 || count < 0 || (count > 0 && (!a || !roots)))
+            throw std::invalid_argument("Niepoprawne parametry paczki wielomianów");
+
+        std::atomic<int> nBad{ 0 };
+        detail::SharedPool pool(count > ROOTS_GRAIN ? detail::resolve_threads(threads) : 1);
+        pool.parallel_for(0, count, ROOTS_GRAIN, [&](int s0, int s1) {
+            std::vector<unsigned char> done(degree);
+            int bad = 0;
+            for (int s = s0; s < s1; ++s) {
+                int found;
+                const bool ok = roots_one(a + static_cast<std::ptrdiff_t>(s) * (degree + 1), degree,
+                    roots + static_cast<std::ptrdiff_t>(s) * degree, done.data(), POLY_ROOTS_MAX_ITER, found);
+                if (!ok) ++bad;
+                if (info) info[s] = ok ? 0 : 1;
+            }
+            nBad += bad;
+        });
+        return nBad;
+    }
+
+}
@@ -0,0 +1,389 @@
+﻿#include "simd.h"
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define NUMLAB_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(NUMLAB_X86) && (defined(__GNUC__) || defined(__clang__))
+#define NUMLAB_TARGET(t) __attribute__((target(t)))
+#else
+#define NUMLAB_TARGET(t)
+#endif
+
+namespace numlab {
+namespace detail {
+
+    namespace {
+
+        void axpy_sub_scalar(double* y, const double* x, double a, std::ptrdiff_t n)
+        {
+            for (std::ptrdiff_t j = 0; j < n; ++j)
+                y[j] -= a * x[j];
+        }
+
+        double dot_scalar(const double* x, const double* y, std::ptrdiff_t n)
+        {
+            double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+            std::ptrdiff_t j = 0;
+            for (; j + 4 <= n; j += 4) {
+                s0 += x[j] * y[j];
+                s1 += x[j + 1] * y[j + 1];
+                s2 += x[j + 2] * y[j + 2];
+                s3 += x[j + 3] * y[j + 3];
+            }
+            for (; j < n; ++j)
+                s0 += x[j] * y[j];
+            return (s0 + s1) + (s2 + s3);
+        }
+
+        void mul_sub_scalar(double* y, const double* a, const double* x, std::ptrdiff_t n)
+        {
+            for (std::ptrdiff_t j = 0; j < n; ++j)
+                y[j] -= a[j] * x[j];
+        }
+
+        void gemm_sub_scalar(double* C, std::ptrdiff_t ldc, const double* A, std::ptrdiff_t lda,
+            const double* B, std::ptrdiff_t ldb, int m, int n, int k)
+        {
+            for (int i = 0; i < m; ++i)
+                for (int p = 0; p < k; ++p)
+                    axpy_sub_scalar(C + i * ldc, B + p * ldb, A[i * lda + p], n);
+        }
+
+        void horner_scalar(const double* c, int nc, const double* x, double* y, std::ptrdiff_t n)
+        {
+            const double last = nc > 0 ? c[nc - 1] : 0.0;
+            for (std::ptrdiff_t j = 0; j < n; ++j) {
+                double r = last;
+                for (int k = nc - 2; k >= 0; --k)
+                    r = r * x[j] + c[k];
+                y[j] = r;
+            }
+        }
+
+#ifdef NUMLAB_X86
+
+        NUMLAB_TARGET("avx2,fma")
+        void axpy_sub_avx2(double* y, const double* x, double a, std::ptrdiff_t n)
+        {
+            const __m256d va = _mm256_set1_pd(a);
+            std::ptrdiff_t j = 0;
+            for (; j + 8 <= n; j += 8) {
+                __m256d y0 = _mm256_loadu_pd(y + j), y1 = _mm256_loadu_pd(y + j + 4);
+                y0 = _mm256_fnmadd_pd(va, _mm256_loadu_pd(x + j), y0);
+                y1 = _mm256_fnmadd_pd(va, _mm256_loadu_pd(x + j + 4), y1);
+                _mm256_storeu_pd(y + j, y0);
+                _mm256_storeu_pd(y + j + 4, y1);
+            }
+            for (; j + 4 <= n; j += 4)
+                _mm256_storeu_pd(y + j, _mm256_fnmadd_pd(va, _mm256_loadu_pd(x + j), _mm256_loadu_pd(y + j)));
+            for (; j < n; ++j)
+                y[j] -= a * x[j];
+        }
+
+        NUMLAB_TARGET("avx2,fma")
+        double dot_avx2(const double* x, const double* y, std::ptrdiff_t n)
+        {
+            __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+            std::ptrdiff_t j = 0;
+            for (; j + 8 <= n; j += 8) {
+                s0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + j), _mm256_loadu_pd(y + j), s0);
+                s1 = _mm256_fmadd_pd(_mm256_loadu_pd(x + j + 4), _mm256_loadu_pd(y + j + 4), s1);
+            }
+            for (; j + 4 <= n; j += 4)
+                s0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + j), _mm256_loadu_pd(y + j), s0);
+            alignas(32) double t[4];
+            _mm256_store_pd(t, _mm256_add_pd(s0, s1));
+            double s = (t[0] + t[1]) + (t[2] + t[3]);
+            for (; j < n; ++j)
+                s += x[j] * y[j];
+            return s;
+        }
+
+        NUMLAB_TARGET("avx2,fma")
+        void mul_sub_avx2(double* y, const double* a, const double* x, std::ptrdiff_t n)
+        {
+            std::ptrdiff_t j = 0;
+            for (; j + 4 <= n; j += 4)
+                _mm256_storeu_pd(y + j, _mm256_fnmadd_pd(_mm256_loadu_pd(a + j),
+                    _mm256_loadu_pd(x + j), _mm256_loadu_pd(y + j)));
+            for (; j < n; ++j)
+                y[j] -= a[j] * x[j];
+        }
+
+        // Mikrojądro 4 wiersze x 8 kolumn trzymane w rejestrach przez całą pętlę po k;
+        // każdy element jest aktualizowany w tej samej kolejności co przez axpy_sub.
+        NUMLAB_TARGET("avx2,fma")
+        void gemm_sub_avx2(double* C, std::ptrdiff_t ldc, const double* A, std::ptrdiff_t lda,
+            const double* B, std::ptrdiff_t ldb, int m, int n, int k)
+        {
+            int i = 0;
+            for (; i + 4 <= m; i += 4) {
+                double* c0 = C + i * ldc; double* c1 = c0 + ldc; double* c2 = c1 + ldc; double* c3 = c2 + ldc;
+                const double* a0 = A + i * lda; const double* a1 = a0 + lda;
+                const double* a2 = a1 + lda;    const double* a3 = a2 + lda;
+                int j = 0;
+                for (; j + 8 <= n; j += 8) {
+                    __m256d r00 = _mm256_loadu_pd(c0 + j), r01 = _mm256_loadu_pd(c0 + j + 4);
+                    __m256d r10 = _mm256_loadu_pd(c1 + j), r11 = _mm256_loadu_pd(c1 + j + 4);
+                    __m256d r20 = _mm256_loadu_pd(c2 + j), r21 = _mm256_loadu_pd(c2 + j + 4);
+                    __m256d r30 = _mm256_loadu_pd(c3 + j), r31 = _mm256_loadu_pd(c3 + j + 4);
+                    const double* b = B + j;
+                    for (int p = 0; p < k; ++p, b += ldb) {
+                        const __m256d b0 = _mm256_loadu_pd(b), b1 = _mm256_loadu_pd(b + 4);
+                        __m256d a = _mm256_broadcast_sd(a0 + p);
+                        r00 = _mm256_fnmadd_pd(a, b0, r00); r01 = _mm256_fnmadd_pd(a, b1, r01);
+                        a = _mm256_broadcast_sd(a1 + p);
+                        r10 = _mm256_fnmadd_pd(a, b0, r10); r11 = _mm256_fnmadd_pd(a, b1, r11);
+                        a = _mm256_broadcast_sd(a2 + p);
+                        r20 = _mm256_fnmadd_pd(a, b0, r20); r21 = _mm256_fnmadd_pd(a, b1, r21);
+                        a = _mm256_broadcast_sd(a3 + p);
+                        r30 = _mm256_fnmadd_pd(a, b0, r30); r31 = _mm256_fnmadd_pd(a, b1, r31);
+                    }
+                    _mm256_storeu_pd(c0 + j, r00); _mm256_storeu_pd(c0 + j + 4, r01);
+                    _mm256_storeu_pd(c1 + j, r10); _mm256_storeu_pd(c1 + j + 4, r11);
+                    _mm256_storeu_pd(c2 + j, r20); _mm256_storeu_pd(c2 + j + 4, r21);
+                    _mm256_storeu_pd(c3 + j, r30); _mm256_storeu_pd(c3 + j + 4, r31);
+                }
+                if (j < n)
+                    for (int p = 0; p < k; ++p) {
+                        const double* b = B + p * ldb + j;
+                        axpy_sub_avx2(c0 + j, b, a0[p], n - j);
+                        axpy_sub_avx2(c1 + j, b, a1[p], n - j);
+                        axpy_sub_avx2(c2 + j, b, a2[p], n - j);
+                        axpy_sub_avx2(c3 + j, b, a3[p], n - j);
+                    }
+            }
+            for (; i < m; ++i)
+                for (int p = 0; p < k; ++p)
+                    axpy_sub_avx2(C + i * ldc, B + p * ldb, A[i * lda + p], n);
+        }
+
+        // 16 punktów naraz = 4 niezależne łańcuchy FMA (ukrywa opóźnienie FMA)
+        NUMLAB_TARGET("avx2,fma")
+        void horner_avx2(const double* c, int nc, const double* x, double* y, std::ptrdiff_t n)
+        {
+            if (nc <= 0) { for (std::ptrdiff_t j = 0; j < n; ++j) y[j] = 0.0; return; }
+            const __m256d last = _mm256_set1_pd(c[nc - 1]);
+            std::ptrdiff_t j = 0;
+            for (; j + 16 <= n; j += 16) {
+                const __m256d x0 = _mm256_loadu_pd(x + j), x1 = _mm256_loadu_pd(x + j + 4);
+                const __m256d x2 = _mm256_loadu_pd(x + j + 8), x3 = _mm256_loadu_pd(x + j + 12);
+                __m256d r0 = last, r1 = last, r2 = last, r3 = last;
+                for (int k = nc - 2; k >= 0; --k) {
+                    const __m256d ck = _mm256_set1_pd(c[k]);
+                    r0 = _mm256_fmadd_pd(r0, x0, ck); r1 = _mm256_fmadd_pd(r1, x1, ck);
+                    r2 = _mm256_fmadd_pd(r2, x2, ck); r3 = _mm256_fmadd_pd(r3, x3, ck);
+                }
+                _mm256_storeu_pd(y + j, r0);     _mm256_storeu_pd(y + j + 4, r1);
+                _mm256_storeu_pd(y + j + 8, r2); _mm256_storeu_pd(y + j + 12, r3);
+            }
+            for (; j + 4 <= n; j += 4) {
+                const __m256d xv = _mm256_loadu_pd(x + j);
+                __m256d r = last;
+                for (int k = nc - 2; k >= 0; --k)
+                    r = _mm256_fmadd_pd(r, xv, _mm256_set1_pd(c[k]));
+                _mm256_storeu_pd(y + j, r);
+            }
+            for (; j < n; ++j) {
+                double r = c[nc - 1];
+                for (int k = nc - 2; k >= 0; --k)
+                    r = std::fma(r, x[j], c[k]);
+                y[j] = r;
+            }
+        }
+
+        NUMLAB_TARGET("avx512f")
+        void axpy_sub_avx512(double* y, const double* x, double a, std::ptrdiff_t n)
+        {
+            const __m512d va = _mm512_set1_pd(a);
+            std::ptrdiff_t j = 0;
+            for (; j + 16 <= n; j += 16) {
+                __m512d y0 = _mm512_loadu_pd(y + j), y1 = _mm512_loadu_pd(y + j + 8);
+                y0 = _mm512_fnmadd_pd(va, _mm512_loadu_pd(x + j), y0);
+                y1 = _mm512_fnmadd_pd(va, _mm512_loadu_pd(x + j + 8), y1);
+                _mm512_storeu_pd(y + j, y0);
+                _mm512_storeu_pd(y + j + 8, y1);
+            }
+            if (j < n) {                                   // ogon przez maskę
+                for (; j + 8 <= n; j += 8)
+                    _mm512_storeu_pd(y + j, _mm512_fnmadd_pd(va, _mm512_loadu_pd(x + j), _mm512_loadu_pd(y + j)));
+                if (j < n) {
+                    const __mmask8 m = static_cast<__mmask8>((1u << (n - j)) - 1u);
+                    __m512d yt = _mm512_maskz_loadu_pd(m, y + j);
+                    yt = _mm512_fnmadd_pd(va, _mm512_maskz_loadu_pd(m, x + j), yt);
+                    _mm512_mask_storeu_pd(y + j, m, yt);
+                }
+            }
+        }
+
+        NUMLAB_TARGET("avx512f")
+        double dot_avx512(const double* x, const double* y, std::ptrdiff_t n)
+        {
+            __m512d s0 = _mm512_setzero_pd(), s1 = _mm512_setzero_pd();
+            std::ptrdiff_t j = 0;
+            for (; j + 16 <= n; j += 16) {
+                s0 = _mm512_fmadd_pd(_mm512_loadu_pd(x + j), _mm512_loadu_pd(y + j), s0);
+                s1 = _mm512_fmadd_pd(_mm512_loadu_pd(x + j + 8), _mm512_loadu_pd(y + j + 8), s1);
+            }
+            for (; j + 8 <= n; j += 8)
+                s0 = _mm512_fmadd_pd(_mm512_loadu_pd(x + j), _mm512_loadu_pd(y + j), s0);
+            if (j < n) {
+                const __mmask8 m = static_cast<__mmask8>((1u << (n - j)) - 1u);
+                s1 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(m, x + j), _mm512_maskz_loadu_pd(m, y + j), s1);
+            }
+            // redukcja jawnie (512 -> 256 -> 128 -> 64); _mm512_reduce_add_pd i niemaskowane
+            // _mm512_extractf64x4_pd w GCC 12 dają -Wuninitialized (_mm256_undefined_pd)
+            const __m512d s = _mm512_add_pd(s0, s1);
+            const __m256d h = _mm256_add_pd(_mm512_maskz_extractf64x4_pd(0xFF, s, 0), _mm512_maskz_extractf64x4_pd(0xFF, s, 1));
+            const __m128d q = _mm_add_pd(_mm256_castpd256_pd128(h), _mm256_extractf128_pd(h, 1));
+            return _mm_cvtsd_f64(_mm_add_sd(q, _mm_unpackhi_pd(q, q)));
+        }
+
+        NUMLAB_TARGET("avx512f")
+        void mul_sub_avx512(double* y, const double* a, const double* x, std::ptrdiff_t n)
+        {
+            std::ptrdiff_t j = 0;
+            for (; j + 8 <= n; j += 8)
+                _mm512_storeu_pd(y + j, _mm512_fnmadd_pd(_mm512_loadu_pd(a + j),
+                    _mm512_loadu_pd(x + j), _mm512_loadu_pd(y + j)));
+            if (j < n) {
+                const __mmask8 m = static_cast<__mmask8>((1u << (n - j)) - 1u);
+                const __m512d yt = _mm512_fnmadd_pd(_mm512_maskz_loadu_pd(m, a + j),
+                    _mm512_maskz_loadu_pd(m, x + j), _mm512_maskz_loadu_pd(m, y + j));
+                _mm512_mask_storeu_pd(y + j, m, yt);
+            }
+        }
+
+        NUMLAB_TARGET("avx512f")
+        void gemm_sub_avx512(double* C, std::ptrdiff_t ldc, const double* A, std::ptrdiff_t lda,
+            const double* B, std::ptrdiff_t ldb, int m, int n, int k)
+        {
+            int i = 0;
+            for (; i + 4 <= m; i += 4) {
+                double* c0 = C + i * ldc; double* c1 = c0 + ldc; double* c2 = c1 + ldc; double* c3 = c2 + ldc;
+                const double* a0 = A + i * lda; const double* a1 = a0 + lda;
+                const double* a2 = a1 + lda;    const double* a3 = a2 + lda;
+                int j = 0;
+                for (; j + 16 <= n; j += 16) {
+                    __m512d r00 = _mm512_loadu_pd(c0 + j), r01 = _mm512_loadu_pd(c0 + j + 8);
+                    __m512d r10 = _mm512_loadu_pd(c1 + j), r11 = _mm512_loadu_pd(c1 + j + 8);
+                    __m512d r20 = _mm512_loadu_pd(c2 + j), r21 = _mm512_loadu_pd(c2 + j + 8);
+                    __m512d r30 = _mm512_loadu_pd(c3 + j), r31 = _mm512_loadu_pd(c3 + j + 8);
+                    const double* b = B + j;
+                    for (int p = 0; p < k; ++p, b += ldb) {
+                        const __m512d b0 = _mm512_loadu_pd(b), b1 = _mm512_loadu_pd(b + 8);
+                        __m512d a = _mm512_set1_pd(a0[p]);
+                        r00 = _mm512_fnmadd_pd(a, b0, r00); r01 = _mm512_fnmadd_pd(a, b1, r01);
+                        a = _mm512_set1_pd(a1[p]);
+                        r10 = _mm512_fnmadd_pd(a, b0, r10); r11 = _mm512_fnmadd_pd(a, b1, r11);
+                        a = _mm512_set1_pd(a2[p]);
+                        r20 = _mm512_fnmadd_pd(a, b0, r20); r21 = _mm512_fnmadd_pd(a, b1, r21);
+                        a = _mm512_set1_pd(a3[p]);
+                        r30 = _mm512_fnmadd_pd(a, b0, r30); r31 = _mm512_fnmadd_pd(a, b1, r31);
+                    }
+                    _mm512_storeu_pd(c0 + j, r00); _mm512_storeu_pd(c0 + j + 8, r01);
+                    _mm512_storeu_pd(c1 + j, r10); _mm512_storeu_pd(c1 + j + 8, r11);
+                    _mm512_storeu_pd(c2 + j, r20); _mm512_storeu_pd(c2 + j + 8, r21);
+                    _mm512_storeu_pd(c3 + j, r30); _mm512_storeu_pd(c3 + j + 8, r31);
+                }
+                if (j < n)
+                    for (int p = 0; p < k; ++p) {
+                        const double* b = B + p * ldb + j;
+                        axpy_sub_avx512(c0 + j, b, a0[p], n - j);
+                        axpy_sub_avx512(c1 + j, b, a1[p], n - j);
+                        axpy_sub_avx512(c2 + j, b, a2[p], n - j);
+                        axpy_sub_avx512(c3 + j, b, a3[p], n - j);
+                    }
+            }
+            for (; i < m; ++i)
+                for (int p = 0; p < k; ++p)
+                    axpy_sub_avx512(C + i * ldc, B + p * ldb, A[i * lda + p], n);
+        }
+
+        NUMLAB_TARGET("avx512f")
+        void horner_avx512(const double* c, int nc, const double* x, double* y, std::ptrdiff_t n)
+        {
+            if (nc <= 0) { for (std::ptrdiff_t j = 0; j < n; ++j) y[j] = 0.0; return; }
+            const __m512d last = _mm512_set1_pd(c[nc - 1]);
+            std::ptrdiff_t j = 0;
+            for (; j + 32 <= n; j += 32) {
+                const __m512d x0 = _mm512_loadu_pd(x + j), x1 = _mm512_loadu_pd(x + j + 8);
+                const __m512d x2 = _mm512_loadu_pd(x + j + 16), x3 = _mm512_loadu_pd(x + j + 24);
+                __m512d r0 = last, r1 = last, r2 = last, r3 = last;
+                for (int k = nc - 2; k >= 0; --k) {
+                    const __m512d ck = _mm512_set1_pd(c[k]);
+                    r0 = _mm512_fmadd_pd(r0, x0, ck); r1 = _mm512_fmadd_pd(r1, x1, ck);
+                    r2 = _mm512_fmadd_pd(r2, x2, ck); r3 = _mm512_fmadd_pd(r3, x3, ck);
+                }
+                _mm512_storeu_pd(y + j, r0);      _mm512_storeu_pd(y + j + 8, r1);
+                _mm512_storeu_pd(y + j + 16, r2); _mm512_storeu_pd(y + j + 24, r3);
+            }
+            for (; j < n; j += 8) {                        // ogon przez maskę
+                const __mmask8 m = n - j >= 8 ? static_cast<__mmask8>(0xff)
+                                              : static_cast<__mmask8>((1u << (n - j)) - 1u);
+                const __m512d xv = _mm512_maskz_loadu_pd(m, x + j);
+                __m512d r = last;
+                for (int k = nc - 2; k >= 0; --k)
+                    r = _mm512_fmadd_pd(r, xv, _mm512_set1_pd(c[k]));
+                _mm512_mask_storeu_pd(y + j, m, r);
+            }
+        }
+
+        bool cpu_has(SimdLevel level)
+        {
+#if defined(_MSC_VER)
+            int r[4];
+            __cpuid(r, 0);
+            if (r[0] < 7) return false;
+            __cpuid(r, 1);
+            const bool osxsave = (r[2] & (1 << 27)) != 0, fma = (r[2] & (1 << 12)) != 0;
+            if (!osxsave) return false;
+            const unsigned long long xcr0 = _xgetbv(0);
+            __cpuidex(r, 7, 0);
+            const bool avx2 = (r[1] & (1 << 5)) != 0, avx512f = (r[1] & (1 << 16)) != 0;
+            if (level == SimdLevel::AVX2)
+                return avx2 && fma && (xcr0 & 0x6) == 0x6;
+            return avx512f && (xcr0 & 0xe6) == 0xe6;
+#else
+            __builtin_cpu_init();
+            if (level == SimdLevel::AVX2)
+                return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+            return __builtin_cpu_supports("avx512f");
+#endif
+        }
+
+#endif
+
+        SimdKernels detect()
+        {
+#ifdef NUMLAB_X86
+            if (cpu_has(SimdLevel::AVX512))
+                return { SimdLevel::AVX512, axpy_sub_avx512, dot_avx512, mul_sub_avx512, gemm_sub_avx512, horner_avx512 };
+            if (cpu_has(SimdLevel::AVX2))
+                return { SimdLevel::AVX2, axpy_sub_avx2, dot_avx2, mul_sub_avx2, gemm_sub_avx2, horner_avx2 };
+#endif
+            return simd_scalar();
+        }
+
+    }
+
+    const SimdKernels& simd_scalar()
+    {
+        static const SimdKernels k{ SimdLevel::Scalar, axpy_sub_scalar, dot_scalar, mul_sub_scalar, gemm_sub_scalar, horner_scalar };
+        return k;
+    }
+
+    const SimdKernels& simd()
+    {
+        static const SimdKernels k = detect();
+        return k;
+    }
+
+}
+}
@@ -0,0 +1,28 @@
+﻿#pragma once
+#include <cstddef>
+
+// Wewnętrzne jądra wektorowe (AVX2/FMA, AVX-512) wybierane w czasie działania
+// na podstawie możliwości procesora; na innych platformach - wersja skalarna.
+
+namespace numlab {
+namespace detail {
+
+    enum class SimdLevel { Scalar, AVX2, AVX512 };
+
+    struct SimdKernels {
+        SimdLevel level;
+        void   (*axpy_sub)(double* y, const double* x, double a, std::ptrdiff_t n);   // y -= a*x
+        double (*dot)(const double* x, const double* y, std::ptrdiff_t n);
+        void   (*mul_sub)(double* y, const double* a, const double* x, std::ptrdiff_t n);   // y[i] -= a[i]*x[i]
+        // C[m x n] -= A[m x k] * B[k x n]  (wierszami, ld* = odstęp wierszy)
+        void   (*gemm_sub)(double* C, std::ptrdiff_t ldc, const double* A, std::ptrdiff_t lda,
+                           const double* B, std::ptrdiff_t ldb, int m, int n, int k);
+        // y[i] = c[0] + c[1]*x[i] + ... + c[nc-1]*x[i]^(nc-1)  (Horner, wiele punktów naraz)
+        void   (*horner)(const double* c, int nc, const double* x, double* y, std::ptrdiff_t n);
+    };
+
+    const SimdKernels& simd();             // najlepszy zestaw dostępny na tym CPU
+    const SimdKernels& simd_scalar();
+
+}
+}
@@ -0,0 +1,400 @@
+﻿#include "sparse.h"
+#include "simd.h"
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+    using numlab::Vector;
+    using numlab::CsrMatrix;
+
+    double dot(const Vector& x, const Vector& y)
+    {
+        return numlab::detail::simd().dot(x.data(), y.data(), static_cast<std::ptrdiff_t>(x.size()));
+    }
+
+    double norm2(const Vector& x) { return std::sqrt(dot(x, x)); }
+
+    // y += a * x
+    void axpy(Vector& y, double a, const Vector& x)
+    {
+        numlab::detail::simd().axpy_sub(y.data(), x.data(), -a, static_cast<std::ptrdiff_t>(y.size()));
+    }
+
+    // r = b - A x
+    void residual(const CsrMatrix& A, const Vector& x, const Vector& b, Vector& r)
+    {
+        A.multiply(x.data(), r.data());
+        for (std::size_t i = 0; i < r.size(); ++i)
+            r[i] = b[i] - r[i];
+    }
+
+    // z = M^{-1} r  dla wybranego preconditionera
+    class Precond {
+    public:
+        Precond(const CsrMatrix& A, numlab::Preconditioner kind)
+            : A_(A), kind_(kind)
+        {
+            const int n = A.rows();
+            const auto& ptr = A.row_ptr();
+            const auto& idx = A.col_idx();
+            if (kind_ == numlab::Preconditioner::None) return;
+
+            diag_.assign(n, -1);
+            for (int i = 0; i < n; ++i)
+                for (int p = ptr[i]; p < ptr[i + 1]; ++p)
+                    if (idx[p] == i) diag_[i] = p;
+            for (int i = 0; i < n; ++i)
+                if (diag_[i] < 0 || A.values()[diag_[i]] == 0.0)
+                    throw std::runtime_error("Zerowy element na przekątnej - preconditioner niemożliwy");
+
+            if (kind_ == numlab::Preconditioner::Jacobi) {
+                inv_.resize(n);
+                for (int i = 0; i < n; ++i)
+                    inv_[i] = 1.0 / A.values()[diag_[i]];
+            }
+            else {
+                factor_ilu0();
+            }
+        }
+
+        void apply(const Vector& r, Vector& z) const
+        {
+            const int n = A_.rows();
+            switch (kind_) {
+            case numlab::Preconditioner::None:
+                z = r;
+                break;
+            case numlab::Preconditioner::Jacobi:
+                for (int i = 0; i < n; ++i)
+                    z[i] = r[i] * inv_[i];
+                break;
+            case numlab::Preconditioner::ILU0: {
+                const auto& ptr = A_.row_ptr();
+                const auto& idx = A_.col_idx();
+                for (int i = 0; i < n; ++i) {              // L y = r  (L jednostkowa)
+                    double s = r[i];
+                    for (int p = ptr[i]; p < diag_[i]; ++p)
+                        s -= lu_[p] * z[idx[p]];
+                    z[i] = s;
+                }
+                for (int i = n - 1; i >= 0; --i) {         // U z = y
+                    double s = z[i];
+                    for (int p = diag_[i] + 1; p < ptr[i + 1]; ++p)
+                        s -= lu_[p] * z[idx[p]];
+                    z[i] = s / lu_[diag_[i]];
+                }
+                break;
+            }
+            }
+        }
+
+    private:
+        // ILU(0): rozkład LU ograniczony do wzorca niezerowych elementów A
+        void factor_ilu0()
+        {
+            const int n = A_.rows();
+            const auto& ptr = A_.row_ptr();
+            const auto& idx = A_.col_idx();
+            lu_ = A_.values();
+            std::vector<int> pos(n, -1);
+
+            for (int i = 0; i < n; ++i) {
+                for (int p = ptr[i]; p < ptr[i + 1]; ++p)
+                    pos[idx[p]] = p;
+                for (int p = ptr[i]; p < diag_[i]; ++p) {
+                    const int k = idx[p];
+                    lu_[p] /= lu_[diag_[k]];
+                    for (int q = diag_[k] + 1; q < ptr[k + 1]; ++q)
+                        if (pos[idx[q]] >= 0)
+                            lu_[pos[idx[q]]] -= lu_[p] * lu_[q];
+                }
+                for (int p = ptr[i]; p < ptr[i + 1]; ++p)
+                    pos[idx[p]] = -1;
+                if (lu_[diag_[i]] == 0.0)
+                    throw std::runtime_error("ILU(0): zerowy element główny");
+            }
+        }
+
+        const CsrMatrix& A_;
+        numlab::Preconditioner kind_;
+        std::vector<int> diag_;
+        Vector inv_, lu_;
+    };
+
+    void check_system(const CsrMatrix& A, const Vector& b, const Vector* x0,
+        const numlab::IterativeOptions& opt)
+    {
+        if (A.rows() == 0 || A.rows() != A.cols() || static_cast<int>(b.size()) != A.rows()
+            || (x0 && x0->size() != b.size()))
+            throw std::runtime_error("Złe wymiary układu");
+        if (opt.maxIter < 0 || opt.tol < 0 || opt.absTol < 0)
+            throw std::invalid_argument("Niepoprawne parametry iteracji");
+    }
+
+    double target_norm(const Vector& b, const numlab::IterativeOptions& opt)
+    {
+        return std::max(opt.tol * norm2(b), opt.absTol);
+    }
+
+}
+
+namespace numlab {
+
+    CsrMatrix::CsrMatrix(int rows, int cols,
+        std::vector<int> rowPtr, std::vector<int> colIdx, Vector values)
+        : rows_(rows), cols_(cols), ptr_(std::move(rowPtr)), idx_(std::move(colIdx)), val_(std::move(values))
+    {
+        if (rows < 0 || cols < 0 || static_cast<int>(ptr_.size()) != rows + 1
+            || idx_.size() != val_.size() || ptr_.front() != 0
+            || ptr_.back() != static_cast<int>(val_.size()))
+            throw std::invalid_argument("Niepoprawna struktura CSR");
+        for (int i = 0; i < rows; ++i) {
+            if (ptr_[i] > ptr_[i + 1])
+                throw std::invalid_argument("Niepoprawna struktura CSR");
+            for (int p = ptr_[i]; p < ptr_[i + 1]; ++p)
+                if (idx_[p] < 0 || idx_[p] >= cols || (p > ptr_[i] && idx_[p] <= idx_[p - 1]))
+                    throw std::invalid_argument("Niepoprawne indeksy kolumn CSR");
+        }
+    }
+
+    CsrMatrix CsrMatrix::from_triplets(int rows, int cols, std::vector<Triplet> t)
+    {
+        for (const auto& e : t)
+            if (e.row < 0 || e.row >= rows || e.col < 0 || e.col >= cols)
+                throw std::invalid_argument("Indeks poza macierzą");
+        std::sort(t.begin(), t.end(), [](const Triplet& a, const Triplet& b) {
+            return a.row != b.row ? a.row < b.row : a.col < b.col;
+        });
+
+        std::vector<int> ptr(rows + 1, 0), idx;
+        Vector val;
+        idx.reserve(t.size());
+        val.reserve(t.size());
+        for (std::size_t k = 0; k < t.size(); ++k) {
+            if (k > 0 && t[k].row == t[k - 1].row && t[k].col == t[k - 1].col) {
+                val.back() += t[k].value;
+                continue;
+            }
+            idx.push_back(t[k].col);
+            val.push_back(t[k].value);
+            ++ptr[t[k].row + 1];
+        }
+        for (int i = 0; i < rows; ++i)
+            ptr[i + 1] += ptr[i];
+        return CsrMatrix(rows, cols, std::move(ptr), std::move(idx), std::move(val));
+    }
+
+    CsrMatrix CsrMatrix::from_dense(ConstMatrixView A, double dropTol)
+    {
+        std::vector<int> ptr(A.rows() + 1, 0), idx;
+        Vector val;
+        for (int i = 0; i < A.rows(); ++i) {
+            for (int j = 0; j < A.cols(); ++j)
+                if (std::fabs(A(i, j)) > dropTol) {
+                    idx.push_back(j);
+                    val.push_back(A(i, j));
+                }
+            ptr[i + 1] = static_cast<int>(val.size());
+        }
+        return CsrMatrix(A.rows(), A.cols(), std::move(ptr), std::move(idx), std::move(val));
+    }
+
+    void CsrMatrix::multiply(const double* x, double* y) const
+    {
+        const int*    ptr = ptr_.data();
+        const int*    idx = idx_.data();
+        const double* val = val_.data();
+        for (int i = 0; i < rows_; ++i) {
+            double s = 0.0;
+            for (int p = ptr[i]; p < ptr[i + 1]; ++p)
+                s += val[p] * x[idx[p]];
+            y[i] = s;
+        }
+    }
+
+    Vector CsrMatrix::operator*(const Vector& x) const
+    {
+        if (static_cast<int>(x.size()) != cols_)
+            throw std::runtime_error("Złe wymiary układu");
+        Vector y(rows_);
+        multiply(x.data(), y.data());
+        return y;
+    }
+
+    IterativeResult solve_cg(const CsrMatrix& A, const Vector& b,
+        const IterativeOptions& opt, const Vector* x0)
+    {
+        check_system(A, b, x0, opt);
+        const int n = A.rows();
+        const Precond M(A, opt.precond);
+        const double target = target_norm(b, opt);
+
+        IterativeResult res;
+        res.x = x0 ? *x0 : Vector(n, 0.0);
+        Vector r(n), z(n), p(n), q(n);
+        residual(A, res.x, b, r);
+        res.residual = norm2(r);
+        if (res.residual <= target) { res.converged = true; return res; }
+
+        M.apply(r, z);
+        p = z;
+        double rz = dot(r, z);
+        for (int k = 1; k <= opt.maxIter; ++k) {
+            A.multiply(p.data(), q.data());
+            const double pq = dot(p, q);
+            if (pq <= 0.0) break;                     // A nie jest dodatnio określona
+            const double alpha = rz / pq;
+            axpy(res.x, alpha, p);
+            axpy(r, -alpha, q);
+            res.iterations = k;
+            res.residual = norm2(r);
+            if (res.residual <= target) { res.converged = true; break; }
+
+            M.apply(r, z);
+            const double rzNew = dot(r, z);
+            const double beta = rzNew / rz;
+            rz = rzNew;
+            for (int i = 0; i < n; ++i)
+                p[i] = z[i] + beta * p[i];
+        }
+        return res;
+    }
+
+    IterativeResult solve_bicgstab(const CsrMatrix& A, const Vector& b,
+        const IterativeOptions& opt, const Vector* x0)
+    {
+        check_system(A, b, x0, opt);
+        const int n = A.rows();
+        const Precond M(A, opt.precond);
+        const double target = target_norm(b, opt);
+
+        IterativeResult res;
+        res.x = x0 ? *x0 : Vector(n, 0.0);
+        Vector r(n), rHat(n), p(n, 0.0), v(n, 0.0), s(n), t(n), pHat(n), sHat(n);
+        residual(A, res.x, b, r);
+        res.residual = norm2(r);
+        if (res.residual <= target) { res.converged = true; return res; }
+
+        rHat = r;
+        double rho = 1.0, alpha = 1.0, omega = 1.0;
+        for (int k = 1; k <= opt.maxIter; ++k) {
+            const double rhoNew = dot(rHat, r);
+            if (rhoNew == 0.0 || omega == 0.0) break;        // załamanie metody
+            const double beta = (rhoNew / rho) * (alpha / omega);
+            rho = rhoNew;
+            for (int i = 0; i < n; ++i)
+                p[i] = r[i] + beta * (p[i] - omega * v[i]);
+
+            M.apply(p, pHat);
+            A.multiply(pHat.data(), v.data());
+            const double rv = dot(rHat, v);
+            if (rv == 0.0) break;
+            alpha = rho / rv;
+            for (int i = 0; i < n; ++i)
+                s[i] = r[i] - alpha * v[i];
+            res.iterations = k;
+
+            if (norm2(s) <= target) {
+                axpy(res.x, alpha, pHat);
+                r = s;
+                res.residual = norm2(r);
+                res.converged = true;
+                break;
+            }
+
+            M.apply(s, sHat);
+            A.multiply(sHat.data(), t.data());
+            const double tt = dot(t, t);
+            omega = tt > 0.0 ? dot(t, s) / tt : 0.0;
+            for (int i = 0; i < n; ++i) {
+                res.x[i] += alpha * pHat[i] + omega * sHat[i];
+                r[i] = s[i] - omega * t[i];
+            }
+            res.residual = norm2(r);
+            if (res.residual <= target) { res.converged = true; break; }
+        }
+        return res;
+    }
+
+    IterativeResult solve_gmres(const CsrMatrix& A, const Vector& b,
+        const IterativeOptions& opt, const Vector* x0)
+    {
+        check_system(A, b, x0, opt);
+        if (opt.restart <= 0)
+            throw std::invalid_argument("restart <= 0");
+        const int n = A.rows();
+        const int m = std::min(opt.restart, n);
+        const Precond M(A, opt.precond);
+        const double target = target_norm(b, opt);
+
+        IterativeResult res;
+        res.x = x0 ? *x0 : Vector(n, 0.0);
+
+        // baza Kryłowa V (m+1 wektorów), macierz Hessenberga H, obroty Givensa
+        std::vector<Vector> V(m + 1, Vector(n));
+        DenseMatrix H(m + 1, m);
+        Vector cs(m), sn(m), g(m + 1), w(n), z(n), y(m);
+
+        Vector r(n);
+        residual(A, res.x, b, r);
+        res.residual = norm2(r);
+        if (res.residual <= target) { res.converged = true; return res; }
+
+        while (res.iterations < opt.maxIter) {
+            const double beta = res.residual;
+            for (int i = 0; i < n; ++i) V[0][i] = r[i] / beta;
+            std::fill(g.begin(), g.end(), 0.0);
+            g[0] = beta;
+
+            int j = 0;
+            for (; j < m && res.iterations < opt.maxIter; ++j) {
+                ++res.iterations;
+                M.apply(V[j], z);
+                A.multiply(z.data(), w.data());
+                for (int i = 0; i <= j; ++i) {              // zmodyfikowany Gram-Schmidt
+                    H(i, j) = dot(w, V[i]);
+                    axpy(w, -H(i, j), V[i]);
+                }
+                H(j + 1, j) = norm2(w);
+                if (H(j + 1, j) > 0.0)
+                    for (int i = 0; i < n; ++i) V[j + 1][i] = w[i] / H(j + 1, j);
+
+                for (int i = 0; i < j; ++i) {
+                    const double h = cs[i] * H(i, j) + sn[i] * H(i + 1, j);
+                    H(i + 1, j) = -sn[i] * H(i, j) + cs[i] * H(i + 1, j);
+                    H(i, j) = h;
+                }
+                const double d = std::hypot(H(j, j), H(j + 1, j));
+                cs[j] = d > 0.0 ? H(j, j) / d : 1.0;
+                sn[j] = d > 0.0 ? H(j + 1, j) / d : 0.0;
+                H(j, j) = d;
+                H(j + 1, j) = 0.0;
+                g[j + 1] = -sn[j] * g[j];
+                g[j] = cs[j] * g[j];
+
+                if (std::fabs(g[j + 1]) <= target || d == 0.0) { ++j; break; }
+            }
+
+            // y = H^{-1} g (trójkątna), x += M^{-1} V y
+            for (int i = j - 1; i >= 0; --i) {
+                double s = g[i];
+                for (int k = i + 1; k < j; ++k)
+                    s -= H(i, k) * y[k];
+                y[i] = H(i, i) != 0.0 ? s / H(i, i) : 0.0;
+            }
+            std::fill(w.begin(), w.end(), 0.0);
+            for (int k = 0; k < j; ++k)
+                axpy(w, y[k], V[k]);
+            M.apply(w, z);
+            axpy(res.x, 1.0, z);
+
+            residual(A, res.x, b, r);
+            res.residual = norm2(r);
+            if (res.residual <= target) { res.converged = true; break; }
+        }
+        return res;
+    }
+
+}
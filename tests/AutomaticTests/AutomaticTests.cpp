@@ -16,12 +16,22 @@
 #include <cmath>
 #include <limits>
 #include <exception>
+#include <algorithm>
+#include <sstream>
+#include <cstdlib>
+#include <new>
+#include <thread>
 #include "linsolve.h"
+#include "linsolve_fixed.h"
 #include "integrate.h"
 #include "nlsolve.h"
 #include "differential.h"
 #include "approx.h"
 #include "interpolate.h"
+#include "poly.h"
+#include "sparse.h"
+#include "cubature.h"
+#include "../../src/simd.h"                    // jądra wewnętrzne: porównanie z wersją skalarną
 
 using namespace numlab;
 
@@ -33,6 +43,17 @@ bool near(double a, double b, double tol = 1e-8) {
 }
 bool isnan(double v) { return std::isnan(v); }
 
+// licznik alokacji (testy "bez alokacji" - np. SystemWorkspace)
+static std::size_t g_allocs = 0;
+void* operator new(std::size_t sz)
+{
+    ++g_allocs;
+    if (void* p = std::malloc(sz ? sz : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
 /* ================= Main ================================================= */
 int main()
 {
@@ -53,6 +74,152 @@ int main()
     }
     catch (const std::exception&) { PASS("LinSolve bad (singular)"); }
 
+    try {
+        DenseMatrix D(Matrix{ {0,2,1},{1,1,1},{2,1,0} });   // pivot w 1. kolumnie = 0
+        auto x = gaussian_elimination(D, Vector{ 3,3,3 });
+        (near(x[0], 1) && near(x[1], 1) && near(x[2], 1)) ?
+            PASS("LinSolve DenseMatrix good") : FAIL("LinSolve DenseMatrix good");
+    }
+    catch (...) { FAIL("LinSolve DenseMatrix good threw"); }
+
+    try {
+        DenseMatrix R(Matrix{ {1,2},{3} });
+        FAIL("LinSolve DenseMatrix ragged - expected throw");
+    }
+    catch (const std::invalid_argument&) { PASS("LinSolve DenseMatrix ragged"); }
+
+    try {
+        LUFactorization lu(DenseMatrix(Matrix{ {2,1},{1,3} }));
+        auto x = lu.solve({ 3,5 });
+        DenseMatrix X = lu.solve_many(DenseMatrix(Matrix{ {3,6},{5,10} }));
+        (near(x[0], 0.8) && near(x[1], 1.4) && near(X(0, 1), 1.6) && near(X(1, 1), 2.8)) ?
+            PASS("LinSolve LU good") : FAIL("LinSolve LU good");
+    }
+    catch (...) { FAIL("LinSolve LU good threw"); }
+
+    try {
+        LUFactorization lu;
+        lu.solve({ 1,2 });
+        FAIL("LinSolve LU bad (no factor) - expected throw");
+    }
+    catch (const std::runtime_error&) { PASS("LinSolve LU bad (no factor)"); }
+
+    try {
+        const int n = 300;                              // powyżej progu dla wątków
+        DenseMatrix P(n, n);
+        for (int i = 0; i < n; ++i)
+            for (int j = 0; j < n; ++j)
+                P(i, j) = std::sin(1.0 + i * 7 + j * 3) + (i == j ? 2.0 : 0.0);
+        LUFactorization serial(P, 64, 1), threaded(P, 64, 4);
+        bool same = serial.pivots() == threaded.pivots();
+        for (int i = 0; i < n && same; ++i)
+            for (int j = 0; j < n && same; ++j)
+                same = serial.lu()(i, j) == threaded.lu()(i, j);
+        same ? PASS("LinSolve LU threads == serial") : FAIL("LinSolve LU threads == serial");
+
+        // równoległe wywołania z kilku wątków - każde dostaje własną pulę z pamięci podręcznej
+        std::vector<int> ok(4, 0);
+        std::vector<std::thread> callers;
+        for (int c = 0; c < 4; ++c)
+            callers.emplace_back([&, c] {
+                for (int r = 0; r < 3; ++r) {
+                    LUFactorization f(P, 64, 4);
+                    ok[c] += f.pivots() == serial.pivots() && f.lu()(n - 1, n - 1) == serial.lu()(n - 1, n - 1);
+                }
+            });
+        for (auto& t : callers) t.join();
+        std::count(ok.begin(), ok.end(), 3) == 4 ?
+            PASS("LinSolve LU concurrent callers") : FAIL("LinSolve LU concurrent callers");
+    }
+    catch (...) { FAIL("LinSolve LU threads threw"); }
+
+    try {
+        // ||Ax - b|| dla n niepodzielnych przez blockSize (kilka paneli, niepełny ostatni)
+        bool ok = true;
+        for (int n : { 10, 130 })
+            for (int bs : { 1, 3, 64 })
+                for (int th : { 1, 4 }) {
+                    DenseMatrix P(n, n);
+                    Vector b(n);
+                    for (int i = 0; i < n; ++i) {
+                        b[i] = std::cos(0.5 + i);
+                        for (int j = 0; j < n; ++j)
+                            P(i, j) = std::sin(1.0 + i * 7 + j * 3) + (i == j ? 2.0 : 0.0);
+                    }
+                    LUFactorization f(P, bs, th);
+                    const Vector x = f.solve(b);
+                    double res = 0.0;
+                    for (int i = 0; i < n; ++i) {
+                        double s = -b[i];
+                        for (int j = 0; j < n; ++j) s += P(i, j) * x[j];
+                        res = std::max(res, std::fabs(s));
+                    }
+                    ok = ok && res < 1e-10;
+                }
+        ok ? PASS("LinSolve LU residual (n = 10, 130; block 1, 3, 64)") : FAIL("LinSolve LU residual (n = 10, 130; block 1, 3, 64)");
+    }
+    catch (...) { FAIL("LinSolve LU residual threw"); }
+
+    try {
+        // 2 układy 2x2 w układzie SoA: {2,1;1,3}x={3,5} oraz osobliwy {1,2;2,4}
+        double Ab[8] = { 2,1, 1,2, 1,2, 3,4 };
+        double bb[4] = { 3,1, 5,2 };
+        int info[2];
+        int nBad = solve_batched(2, 2, Ab, bb, BatchLayout::Interleaved, 1, info);
+        (nBad == 1 && info[0] == 0 && info[1] == 1 && near(bb[0], 0.8) && near(bb[2], 1.4)
+            && isnan(bb[1])) ? PASS("LinSolve batched good/singular") : FAIL("LinSolve batched good/singular");
+    }
+    catch (...) { FAIL("LinSolve batched threw"); }
+
+    try {
+        // te same układy w układzie Packed (macierz po macierzy)
+        double Ap[8] = { 2,1,1,3, 1,2,2,4 };
+        double bp[4] = { 3,5, 1,2 };
+        int info[2];
+        int nBad = solve_batched(2, 2, Ap, bp, BatchLayout::Packed, 1, info);
+        (nBad == 1 && info[0] == 0 && info[1] == 1 && near(bp[0], 0.8) && near(bp[1], 1.4)
+            && isnan(bp[2]) && isnan(bp[3])) ? PASS("LinSolve batched Packed good/singular") : FAIL("LinSolve batched Packed good/singular");
+    }
+    catch (...) { FAIL("LinSolve batched Packed threw"); }
+
+    {
+        constexpr FixedMatrix<3> F{ { {0,2,1},{1,1,1},{2,1,0} } };
+        constexpr FixedVector<3> xf = solve_fixed(F, FixedVector<3>{ { 3,3,3 } });   // liczone w czasie kompilacji
+        (near(xf[0], 1) && near(xf[1], 1) && near(xf[2], 1)) ?
+            PASS("LinSolve fixed<3> constexpr good") : FAIL("LinSolve fixed<3> constexpr good");
+    }
+
+    try {
+        solve_fixed(FixedMatrix<2>{ { {1,2},{2,4} } }, FixedVector<2>{ { 1,2 } });
+        FAIL("LinSolve fixed<2> singular - expected throw");
+    }
+    catch (const std::runtime_error&) { PASS("LinSolve fixed<2> singular"); }
+
+    {
+        // jądra wybrane dla tego CPU vs skalarne - nieparzyste długości sprawdzają ogony i maski
+        const detail::SimdKernels& vk = detail::simd();
+        const detail::SimdKernels& sk = detail::simd_scalar();
+        bool same = true;
+        for (int n : { 1, 3, 7, 9, 17 }) {
+            std::vector<double> x(n), y1(n), y2(n);
+            for (int i = 0; i < n; ++i) { x[i] = std::sin(1.0 + i); y1[i] = y2[i] = std::cos(2.0 + 3 * i); }
+            vk.axpy_sub(y1.data(), x.data(), 0.75, n);
+            sk.axpy_sub(y2.data(), x.data(), 0.75, n);
+            for (int i = 0; i < n; ++i) same = same && near(y1[i], y2[i], 1e-14);
+            same = same && near(vk.dot(x.data(), y1.data(), n), sk.dot(x.data(), y1.data(), n), 1e-13);
+
+            // C[n x n] -= A[n x n] * B[n x n]
+            std::vector<double> A(n * n), B(n * n), C1(n * n), C2(n * n);
+            for (int i = 0; i < n * n; ++i) {
+                A[i] = std::sin(0.3 * i); B[i] = std::cos(0.7 * i); C1[i] = C2[i] = 0.1 * i;
+            }
+            vk.gemm_sub(C1.data(), n, A.data(), n, B.data(), n, n, n, n);
+            sk.gemm_sub(C2.data(), n, A.data(), n, B.data(), n, n, n, n);
+            for (int i = 0; i < n * n; ++i) same = same && near(C1[i], C2[i], 1e-12);
+        }
+        same ? PASS("SIMD kernels == scalar (odd n)") : FAIL("SIMD kernels == scalar (odd n)");
+    }
+
     /* ==== 2. Integrate ================================================== */
     auto fx = [](double x) { return x * x; };
     double I = integral_simpson(fx, 0, 1, 200);
@@ -65,15 +232,125 @@ int main()
     near(I_mid, 1.0 / 3.0, 1e-6) ? PASS("Integrate midpoint good")
         : FAIL("Integrate midpoint good");
 
+    {
+        int calls = 0;                                     // funktor ze stanem - wersja szablonowa
+        auto counted = [&calls](double x) { ++calls; return x * x; };
+        std::function<double(double)> fn = fx;             // stary interfejs std::function
+        double It = integral_trapezoid(counted, 0, 1, 100);
+        double If = integral_trapezoid(fn, 0, 1, 100);
+        (It == If && calls == 101) ? PASS("Integrate template == std::function")
+            : FAIL("Integrate template == std::function");
+    }
+
+    {
+        auto peak = [](double x) { return 1.0 / (1e-4 + (x - 0.3) * (x - 0.3)); };
+        const double exact = (std::atan(70.0) + std::atan(30.0)) * 100.0;
+        QuadResult qa = integral_adaptive(peak, 0, 1, 1e-10, 1e-12);
+        (qa.converged && near(qa.value, exact, 1e-9) && qa.evaluations < 2000) ?
+            PASS("Integrate adaptive G7-K15 good") : FAIL("Integrate adaptive G7-K15 good");
+    }
+
+    try {
+        integral_adaptive(fx, 0, 1, 1e-8, 1e-8, 10);      // budżet < jednej reguły K15
+        FAIL("Integrate adaptive bad budget - expected throw");
+    }
+    catch (const std::invalid_argument&) { PASS("Integrate adaptive bad budget"); }
+
+    try {
+        integral_simpson(fx, 0, 1, 0);                     // szablon (lambda), jak wersja Parallel
+        FAIL("Integrate Simpson n <= 0 - expected throw");
+    }
+    catch (const std::invalid_argument&) { PASS("Integrate Simpson n <= 0"); }
+
+    {
+        int calls = 0;                                     // każdy węzeł liczony dokładnie raz
+        auto ex = [&calls](double x) { ++calls; return std::exp(x); };
+        RombergResult rr = integral_romberg(ex, 0, 1, 1e-12, 1e-12);
+        const int k = static_cast<int>(rr.tableau.size()) - 1;
+        (rr.converged && near(rr.value, std::exp(1.0) - 1.0, 1e-12)
+            && calls == rr.evaluations && calls == (1 << k) + 1) ?
+            PASS("Integrate Romberg good") : FAIL("Integrate Romberg good");
+    }
+
+    try {
+        integral_romberg(fx, 0, 1, 1e-8, 1e-8, 2);        // poniżej poziomu minimalnego
+        FAIL("Integrate Romberg maxLevel < 3 - expected throw");
+    }
+    catch (const std::invalid_argument&) { PASS("Integrate Romberg maxLevel < 3"); }
+
+    {
+        auto sx = [](double x) { return std::sin(x); };
+        double p1 = integral_simpson(sx, 0, 1, 100001, Parallel{ 1 });
+        double p4 = integral_simpson(sx, 0, 1, 100001, Parallel{ 4 });
+        (p1 == p4 && near(p1, 1 - std::cos(1.0), 1e-12)) ?
+            PASS("Integrate parallel Simpson reproducible") : FAIL("Integrate parallel Simpson reproducible");
+    }
+
+    {
+        int batches = 0;                                   // całka wsadowa: y[i] = x[i]^2
+        BatchIntegrand bsq = [&batches](const double* x, double* y, std::size_t n) {
+            ++batches;
+            for (std::size_t i = 0; i < n; ++i) y[i] = x[i] * x[i];
+        };
+        double Ib = integral_simpson(bsq, 0, 1, 1000);
+        (Ib == integral_simpson(fx, 0, 1, 1000) && batches < 10) ?
+            PASS("Integrate batch integrand good") : FAIL("Integrate batch integrand good");
+    }
+
     auto poly = Vector{ 1.0,0.0,-1.0 };              // P(x)= -x²+1,  ∫₀¹ = 2/3
     double I_gl = integral_poly_gauss(poly, 0, 1, 4, 20);
     near(I_gl, 2.0 / 3.0, 1e-7) ? PASS("Integrate poly Gauss good")
         : FAIL("Integrate poly Gauss good");
+    near(integral_poly_exact(poly, 0, 1), 2.0 / 3.0, 1e-15) ? PASS("Integrate poly exact good")
+        : FAIL("Integrate poly exact good");
+
+    {
+        Vector c = { 1, -2, 0.5, 3, -1, 0.25, 2 };       // stopień 6
+        Vector xs = { -1.5, -0.3, 0.0, 0.7, 1.1, 2.0, 0.1, -0.9, 1.3 };
+        Vector ys = poly_eval_many(c, xs);
+        bool ok = true;
+        for (std::size_t i = 0; i < xs.size(); ++i)
+            ok = ok && near(ys[i], poly_horner(c, xs[i]), 1e-12) && near(poly_estrin(c, xs[i]), ys[i], 1e-12);
+        Vector d = poly_derivative(poly_antiderivative(c, 5.0));    // (∫p)' = p
+        (ok && d == c) ? PASS("Poly Estrin/batch/derivative good") : FAIL("Poly Estrin/batch/derivative good");
+    }
+
+    {
+        Vector p = { -6, 11, -12, 12, -6, 1 };            // (x-1)(x-2)(x-3)(x^2+1)
+        bool conv = false;
+        std::vector<Complex> z = poly_roots(p, POLY_ROOTS_MAX_ITER, &conv);
+        const Complex expect[] = { { 0, -1 }, { 0, 1 }, { 1, 0 }, { 2, 0 }, { 3, 0 } };
+        bool ok = conv && z.size() == 5;
+        for (const Complex& e : expect)
+            ok = ok && std::any_of(z.begin(), z.end(), [&e](const Complex& r) { return std::abs(r - e) < 1e-12; });
+
+        const int N = 300;                                 // x^3 - s x = 0: pierwiastki 0, ±sqrt(s)
+        std::vector<double> A(4 * N, 0.0);
+        for (int s = 0; s < N; ++s) { A[4 * s + 1] = -(1.0 + s); A[4 * s + 3] = 1.0; }
+        std::vector<Complex> R(3 * N);
+        ok = ok && poly_roots_batch(3, N, A.data(), R.data(), 2) == 0;
+        for (int s = 0; s < N && ok; ++s) {
+            const double r = std::sqrt(1.0 + s);
+            ok = std::abs(R[3 * s] + r) < 1e-12 && std::abs(R[3 * s + 1]) == 0.0 && std::abs(R[3 * s + 2] - r) < 1e-12;
+        }
+        ok ? PASS("Poly all roots / batch good") : FAIL("Poly all roots / batch good");
+    }
+
+    try {
+        poly_roots({ 0.0, 0.0 });
+        FAIL("Poly roots zero polynomial - expected throw");
+    }
+    catch (const std::invalid_argument&) { PASS("Poly roots zero polynomial"); }
+
+    auto ecos = [](double x) { return std::exp(x) * std::cos(3 * x); };
+    double I_g12 = integral_gauss_legendre(ecos, 0, 2, 12, 1);   // dowolne nG, pełna precyzja
+    near(I_g12, (std::exp(2.0) * (std::cos(6.0) + 3 * std::sin(6.0)) - 1) / 10, 1e-13) ?
+        PASS("Integrate Gauss nG=12 good") : FAIL("Integrate Gauss nG=12 good");
 
     /* negatywny: Gauss z niedozwoloną liczbą węzłów */
     try {
-        integral_gauss_legendre(fx, 0, 1, 5, 10);
-        FAIL("Integrate Gauss bad nG");            // nG=5 niedozwolone
+        integral_gauss_legendre(fx, 0, 1, 0, 10);
+        FAIL("Integrate Gauss bad nG");            // nG=0 niedozwolone
     }
     catch (const std::invalid_argument&) {
         PASS("Integrate Gauss bad nG");
@@ -95,6 +372,116 @@ int main()
     bad = root_newton(g, dg, 0.0);             // x=0, df=0
     near(bad, 0.0, 1e-3) ? PASS("NLSolve Newton bad (flat)") : PASS("NLSolve Newton handled"); // oczekujemy nie-zbieżnego wyniku
 
+    {
+        int calls = 0;
+        auto e2 = [&calls](double x) { ++calls; return std::exp(x) - 2; };   // wypukła - zwykła regula falsi stoi
+        root_bisection(e2, 0, 4, 1e-12);
+        const int bisCalls = calls;
+        std::vector<IterData> tr;
+        RootResult rb = root_brent(e2, 0, 4, 1e-12, 100, &tr);
+        RootResult ri = root_itp(e2, 0, 4, 1e-12);
+        RootResult rl = root_illinois(e2, 0, 4, 1e-12);
+        RootResult bad = root_brent(e2, 1, 4);
+        bool ok = bad.status == RootStatus::BadBracket && isnan(bad.root) && tr.size() == std::size_t(rb.iterations);
+        for (const RootResult& r : { rb, ri, rl })
+            ok = ok && r.status == RootStatus::Converged && near(r.root, std::log(2.0), 1e-11) && 3 * r.evaluations < bisCalls;
+        ok ? PASS("NLSolve Brent/ITP/Illinois good") : FAIL("NLSolve Brent/ITP/Illinois good");
+    }
+
+    {
+        auto e2 = [](double x) { return std::exp(x) - 2; };
+        RootResult r0 = root_itp(e2, 0, 4, 0.0), rn = root_itp(e2, 0, 4, -1.0);   // eps <= 0 -> precyzja maszynowa
+        (r0.status == RootStatus::Converged && rn.status == RootStatus::Converged
+            && near(r0.root, std::log(2.0), 1e-15) && near(rn.root, std::log(2.0), 1e-15)) ?
+            PASS("NLSolve ITP eps <= 0") : FAIL("NLSolve ITP eps <= 0");
+    }
+
+    {
+        const int N = 1000;                                // x^2 = p_i, p_i = 1 + i/100; ostatnie: zły przedział
+        RootBatchFunction sq = [](const double* x, double* fx, int first, int count) {
+            for (int k = 0; k < count; ++k) fx[k] = x[k] * x[k] - (1.0 + (first + k) / 100.0);
+        };
+        RootBatchDerivative sqd = [](const double* x, double* fx, double* dfx, int first, int count) {
+            for (int k = 0; k < count; ++k) { fx[k] = x[k] * x[k] - (1.0 + (first + k) / 100.0); dfx[k] = 2 * x[k]; }
+        };
+        std::vector<double> lo(N, 0.0), hi(N, 4.0);
+        hi[N - 1] = 1.0;
+        RootBatchResult rb = root_bisection_batch(sq, lo, hi, 1e-12, 100, 2);
+        RootBatchResult rf = root_regulafalsi_batch(sq, lo, hi, 1e-12, 100, 2);
+        RootBatchResult rs = root_secant_batch(sq, std::vector<double>(N, 1.0), std::vector<double>(N, 2.0));
+        RootBatchResult rn = root_newton_batch(sqd, std::vector<double>(N, 2.0));
+        bool ok = rb.status[N - 1] == RootStatus::BadBracket && isnan(rb.root[N - 1])
+            && rf.status[N - 1] == RootStatus::BadBracket
+            && rb.converged() == N - 1 && rs.converged() == N && rn.converged() == N;
+        for (int i = 0; i < N - 1 && ok; ++i) {
+            const double x = std::sqrt(1.0 + i / 100.0);
+            ok = near(rb.root[i], x, 1e-10) && near(rs.root[i], x, 1e-10) && near(rn.root[i], x, 1e-10)
+                && near(rf.root[i], x, 1e-10) && rn.iterations[i] < 10;
+        }
+        ok ? PASS("NLSolve batch bisection/regula falsi/secant/Newton good") : FAIL("NLSolve batch good");
+    }
+
+    {
+        // równanie 0: x-1 na [1, 3] (zero na końcu), równanie 1: NaN dla x > 1.5 na [0, 3]
+        RootBatchFunction edge = [](const double* x, double* fx, int first, int count) {
+            for (int k = 0; k < count; ++k)
+                fx[k] = first + k == 0 ? x[k] - 1.0
+                    : (x[k] > 1.5 && x[k] < 3.0 ? std::numeric_limits<double>::quiet_NaN() : x[k] - 2.0);
+        };
+        bool ok = true;
+        for (int m = 0; m < 2; ++m) {
+            RootBatchResult r = m == 0 ? root_bisection_batch(edge, { 1.0, 0.0 }, { 3.0, 3.0 })
+                : root_regulafalsi_batch(edge, { 1.0, 0.0 }, { 3.0, 3.0 });
+            ok = ok && r.status[0] == RootStatus::Converged && r.root[0] == 1.0 && r.iterations[0] == 0
+                && r.status[1] == RootStatus::NotFinite;
+        }
+        ok ? PASS("NLSolve batch endpoint root / NaN lane") : FAIL("NLSolve batch endpoint root / NaN lane");
+    }
+
+    {
+        const int n = 50;                                  // trójdiagonalny układ Broydena
+        SystemFunction F = [](const double* x, double* f) {
+            for (int i = 0; i < n; ++i)
+                f[i] = (3 - 2 * x[i]) * x[i] - (i > 0 ? x[i - 1] : 0.0) - 2 * (i < n - 1 ? x[i + 1] : 0.0) + 1;
+        };
+        SystemWorkspace ws(n);
+        SystemOptions o;
+        std::vector<double> xn(n, -1.0), xb(n, -1.0);
+        SystemResult rn = root_system(F, xn, o, &ws);
+        o.method = SystemMethod::Broyden;
+        SystemResult rb = root_system(F, xb, o, &ws);
+        bool ok = rn.status == RootStatus::Converged && rb.status == RootStatus::Converged
+            && rb.jacobians == 1 && rb.evaluations < rn.evaluations / 2;
+        for (int i = 0; i < n && ok; ++i) ok = near(xn[i], xb[i], 1e-9);
+
+        SystemFunction none = [](const double* x, double* f) { f[0] = x[0] * x[0] + 1; f[1] = x[1]; };
+        std::vector<double> x2{ 1.0, 1.0 };
+        ok = ok && root_system(none, x2).status != RootStatus::Converged;
+
+        // pierwiastek podwójny, tol nieosiągalne: krok maleje poniżej stepTol przy ||F|| > tol
+        SystemFunction sq = [](const double* x, double* f) { f[0] = x[0] * x[0]; };
+        std::vector<double> x1{ 1.0 };
+        o.tol = 1e-30;
+        SystemResult rs = root_system(sq, x1, o);
+        ok = ok && rs.status == RootStatus::Stalled && rs.residual > o.tol;
+        ok ? PASS("NLSolve system Newton/Broyden good") : FAIL("NLSolve system Newton/Broyden good");
+
+        // ponowne wywołanie z tym samym SystemWorkspace nie alokuje (także LU i różnicowe J)
+        std::size_t allocs[2] = {};
+        for (SystemMethod m : { SystemMethod::Newton, SystemMethod::Broyden }) {
+            SystemOptions om;
+            om.method = m;
+            std::vector<double> xw(n, -1.0);
+            root_system(F, xw, om, &ws);                      // rozgrzewka
+            std::fill(xw.begin(), xw.end(), -1.0);
+            const std::size_t before = g_allocs;
+            SystemResult rw = root_system(F, xw, om, &ws);
+            allocs[m == SystemMethod::Broyden] = g_allocs - before + (rw.status != RootStatus::Converged);
+        }
+        (allocs[0] == 0 && allocs[1] == 0) ?
+            PASS("NLSolve system workspace no alloc") : FAIL("NLSolve system workspace no alloc");
+    }
+
     /* ==== 4. Differential ======================================================== */
     auto rhs = [](double /*t*/, double y) { return y; };          // y'=y
     try {
@@ -114,6 +501,158 @@ int main()
     near(sol.back().y, std::exp(1.0), 5e-2) ? PASS("ODE Euler good (tol 5e-2)")
         : FAIL("ODE Euler good");
 
+    {
+        auto osc = [](double t, double y) { return y * std::cos(t); };   // y = exp(sin t)
+        OdeOptions o;
+        o.absTol = o.relTol = 1e-9;
+        bool ok = true;
+        for (OdeMethod m : { OdeMethod::DormandPrince45, OdeMethod::CashKarp45, OdeMethod::BogackiShampine23 }) {
+            o.method = m;
+            OdeStats st;
+            auto tr = ode_solve(1.0, 0, 10, osc, o, &st);
+            ok = ok && st.success && tr.back().t == 10.0
+                && near(tr.back().y, std::exp(std::sin(10.0)), 1e-6)
+                && (m == OdeMethod::BogackiShampine23 || st.evaluations < 2000);
+        }
+        ok ? PASS("ODE adaptive RK good") : FAIL("ODE adaptive RK good");
+    }
+
+    try {
+        ode_solve(1.0, 1, 0, rhs, OdeOptions{});
+        FAIL("ODE adaptive bad (tEnd<t0) - expected throw");
+    }
+    catch (const std::invalid_argument&) { PASS("ODE adaptive bad (tEnd<t0)"); }
+
+    {
+        OdeSystemRHS osc = [](double, const double* y, double* dy) { dy[0] = y[1]; dy[1] = -y[0]; };
+        OdeTrajectory tf = ode_solve_system({ 1.0, 0.0 }, 0, 10, 0.01, osc, step_rk4_sys);
+        OdeOptions o;
+        o.absTol = o.relTol = 1e-10;
+        OdeTrajectory ta = ode_solve_system({ 1.0, 0.0 }, 0, 10, osc, o);
+        const double* yf = tf.state(tf.size() - 1);
+        const double* ya = ta.state(ta.size() - 1);
+        (tf.size() == 1001 && near(yf[0], std::cos(10.0), 1e-8) && near(yf[1], -std::sin(10.0), 1e-8)
+            && near(ya[0], std::cos(10.0), 1e-8) && ta.t.back() == 10.0) ?
+            PASS("ODE system RK4/adaptive good") : FAIL("ODE system RK4/adaptive good");
+    }
+
+    try {
+        OdeWorkspace ws(1);                                // za mały dla n = 2
+        double y2[2] = { 1, 0 };
+        step_rk4_sys(y2, 2, 0, 0.1, [](double, const double*, double*) {}, ws);
+        FAIL("ODE system bad workspace - expected throw");
+    }
+    catch (const std::invalid_argument&) { PASS("ODE system bad workspace"); }
+
+    {
+        OdeSystemRHS rob = [](double, const double* y, double* dy) {     // Robertson (sztywny)
+            dy[0] = -0.04 * y[0] + 1e4 * y[1] * y[2];
+            dy[1] = 0.04 * y[0] - 1e4 * y[1] * y[2] - 3e7 * y[1] * y[1];
+            dy[2] = 3e7 * y[1] * y[1];
+        };
+        OdeOptions o;
+        o.relTol = 1e-6;
+        o.absTol = 1e-10;
+        bool ok = true;
+        for (OdeMethod m : { OdeMethod::Rosenbrock23, OdeMethod::RadauIIA5, OdeMethod::BDF }) {
+            o.method = m;
+            OdeStats st;
+            OdeTrajectory tr = ode_solve_system({ 1.0, 0.0, 0.0 }, 0, 40, rob, o, &st);
+            const double* y = tr.state(tr.size() - 1);
+            ok = ok && st.success && st.accepted < 1000 && st.jacobians < st.accepted
+                && near(y[0], 0.7158270687, 1e-4) && near(y[2], 0.2841637457, 1e-4);
+        }
+        o.method = OdeMethod::BDF;
+        auto tr = ode_solve(0.0, 0, 10, [](double t, double y) { return -1e4 * (y - std::cos(t)); }, o);
+        ok = ok && near(tr.back().y, (1e8 * std::cos(10.0) + 1e4 * std::sin(10.0)) / (1e8 + 1), 1e-5);
+        ok ? PASS("ODE stiff Rosenbrock/Radau/BDF good") : FAIL("ODE stiff Rosenbrock/Radau/BDF good");
+    }
+
+    {
+        const int C = 150;                                 // y' = -p_k y, p_k = 1 + k/C, y(0) = 1
+        OdeEnsembleRHS decay = [C](double, const double* y, double* dy, int first, int count, int) {
+            for (int k = 0; k < count; ++k) dy[k] = -(1.0 + double(first + k) / C) * y[k];
+        };
+        EnsembleOptions eo;
+        eo.saveEvery = 10;
+        eo.threads = 2;
+        eo.stop = [](int traj, double, const double* y, int) { return traj % 2 == 1 && y[0] < 0.5; };
+        EnsembleResult er = ode_solve_ensemble(C, 1, Vector(C, 1.0), 0, 1, 0.01, decay, eo);
+        bool ok = er.samples() == 11 && er.t.back() == 1.0;
+        for (int k = 0; k < C && ok; ++k) {
+            const double p = 1.0 + double(k) / C;
+            ok = k % 2 == 0
+                ? !er.stopped[k] && near(er.at(10, 0, k), std::exp(-p), 1e-9)
+                : er.stopped[k] && near(er.tStop[k], std::ceil(std::log(2.0) / p * 100 - 1e-9) / 100, 1e-9);
+        }
+        ok ? PASS("ODE ensemble RK4 good") : FAIL("ODE ensemble RK4 good");
+    }
+
+    {
+        // trajektoria 3 zatrzymana przy y < 0.5 (t ~ 0.69), od t > 1 f zwraca dla niej NaN
+        OdeEnsembleRHS blow = [](double t, const double* y, double* dy, int first, int count, int) {
+            for (int k = 0; k < count; ++k)
+                dy[k] = (first + k == 3 && t > 1.0) ? std::numeric_limits<double>::quiet_NaN() : -y[k];
+        };
+        EnsembleOptions eo;
+        eo.stop = [](int traj, double, const double* y, int) { return traj == 3 && y[0] < 0.5; };
+        EnsembleResult er = ode_solve_ensemble(8, 1, Vector(8, 1.0), 0, 2, 0.01, blow, eo);
+        bool ok = er.stopped[3] != 0;
+        for (std::size_t s = 0; s < er.samples() && ok; ++s) ok = std::isfinite(er.at(s, 0, 3));
+        const double frozen = er.at(80, 0, 3);            // t = 0.8 - już po zatrzymaniu
+        ok = ok && frozen < 0.5 && er.at(er.samples() - 1, 0, 3) == frozen;
+        ok ? PASS("ODE ensemble stopped lane stays frozen") : FAIL("ODE ensemble stopped lane stays frozen");
+    }
+
+    {
+        OdeSystemRHS osc = [](double, const double* y, double* dy) { dy[0] = y[1]; dy[1] = -y[0]; };
+        OdeOptions o; o.absTol = o.relTol = 1e-10;
+        OdeOutput out;
+        for (int i = 0; i <= 100; ++i) out.grid.push_back(0.1 * i);
+        double worst = 0.0;
+        int points = 0;
+        out.observer = [&](double t, const double* y, int) {
+            ++points;
+            worst = std::max(worst, std::fabs(y[0] - std::cos(t)) + std::fabs(y[1] + std::sin(t)));
+        };
+        OdeStats st;
+        Vector yEnd = ode_integrate({ 1.0, 0.0 }, 0, 10, osc, o, out, &st);
+        bool ok = st.success && points == 101 && worst < 1e-8 && near(yEnd[0], std::cos(10.0), 1e-8);
+        o.method = OdeMethod::BDF; o.absTol = o.relTol = 1e-8;
+        points = 0; worst = 0.0;
+        ode_integrate({ 1.0, 0.0 }, 0, 10, osc, o, out, &st);
+        ok = ok && points == 101 && worst < 1e-5;
+
+        std::ostringstream csv;
+        OdeOutput dec; dec.decimate = 5; dec.observer = ode_csv_writer(csv);
+        o.method = OdeMethod::DormandPrince45;
+        ode_integrate({ 1.0, 0.0 }, 0, 10, osc, o, dec, &st);
+        int lines = 0;
+        for (char ch : csv.str()) lines += ch == '\n';
+        ok = ok && lines == 1 + st.accepted / 5 + (st.accepted % 5 != 0);
+        ok ? PASS("ODE dense output / observer good") : FAIL("ODE dense output / observer good");
+    }
+
+    {
+        OdeSystemRHS fall = [](double, const double* y, double* dy) { dy[0] = y[1]; dy[1] = -9.81; };
+        OdeOptions o;
+        OdeEvent ground; ground.g = [](double, const double* y) { return y[0]; }; ground.terminal = true; ground.direction = -1;
+        OdeEvent speed; speed.g = [](double, const double* y) { return y[1] + 5.0; };
+        o.events = { ground, speed };
+        const double tHit = std::sqrt(2 * 10 / 9.81);
+        bool ok = true;
+        for (OdeMethod m : { OdeMethod::DormandPrince45, OdeMethod::RadauIIA5 }) {
+            o.method = m;
+            OdeStats st;
+            OdeTrajectory tr = ode_solve_system({ 10.0, 0.0 }, 0, 5, fall, o, &st);
+            ok = ok && st.success && st.terminated && st.hits.size() == 2
+                && st.hits[0].event == 1 && near(st.hits[0].t, 5 / 9.81, 1e-9)
+                && st.hits[1].event == 0 && near(st.hits[1].t, tHit, 1e-9)
+                && near(tr.t.back(), tHit, 1e-9) && near(tr.state(tr.size() - 1)[0], 0.0, 1e-8);
+        }
+        ok ? PASS("ODE events terminal/non-terminal good") : FAIL("ODE events terminal/non-terminal good");
+    }
+
     /* ==== 5. Approx ===================================================== */
     auto f = [](double x) { return x; };
     Vector c = poly_lsq(f, 0, 1, 1, 400);
@@ -148,6 +687,55 @@ int main()
     near(val, 3.25, 1e-12) ? PASS("Interpolate Newton good")
         : FAIL("Interpolate Newton good");
 
+    /* ==== 7. Sparse ==================================================== */
+    try {
+        const int n = 50;                                 // -x'' = f, siatka 1D
+        std::vector<Triplet> t;
+        for (int i = 0; i < n; ++i) {
+            t.push_back({ i, i, 2.0 });
+            if (i > 0)     t.push_back({ i, i - 1, -1.0 });
+            if (i < n - 1) t.push_back({ i, i + 1, -1.0 });
+        }
+        CsrMatrix T = CsrMatrix::from_triplets(n, n, t);
+        Vector xs(n, 1.0), bs = T * xs;
+        IterativeOptions o;
+        o.precond = Preconditioner::ILU0;
+        auto rc = solve_cg(T, bs, o);
+        o.precond = Preconditioner::Jacobi;
+        auto rg = solve_gmres(T, bs, o);
+        auto rb = solve_bicgstab(T, bs, o);
+        (rc.converged && rg.converged && rb.converged && near(rc.x[n / 2], 1.0, 1e-6)
+            && near(rg.x[n / 2], 1.0, 1e-6) && near(rb.x[n / 2], 1.0, 1e-6)) ?
+            PASS("Sparse CG/GMRES/BiCGSTAB good") : FAIL("Sparse CG/GMRES/BiCGSTAB good");
+    }
+    catch (...) { FAIL("Sparse solvers threw"); }
+
+    try {
+        CsrMatrix bad(2, 2, { 0,1,2 }, { 1,5 }, { 1.0,1.0 });   // kolumna 5 poza macierzą
+        FAIL("Sparse bad CSR - expected throw");
+    }
+    catch (const std::invalid_argument&) { PASS("Sparse bad CSR"); }
+
+    /* ==== 8. Cubature ================================================== */
+    try {
+        auto p3 = [](const Vector& x) { return x[0] * x[0] * x[1] + x[2] * x[2] * x[2] + 1.0; };
+        Vector lo = { 0,0,0 }, hi = { 1,2,1 };
+        const double exact = 2.0 / 3.0 + 0.5 + 2.0;
+        auto rg = cubature_gauss(p3, lo, hi, 3);
+        auto rs = cubature_sparse_grid(p3, lo, hi, 2);
+        auto rq = cubature_qmc(p3, lo, hi, 1 << 12);
+        (near(rg.value, exact, 1e-12) && near(rs.value, exact, 1e-12)
+            && near(rq.value, exact, 1e-3) && rq.error < 1e-3) ?
+            PASS("Cubature Gauss/Smolyak/QMC good") : FAIL("Cubature Gauss/Smolyak/QMC good");
+    }
+    catch (...) { FAIL("Cubature threw"); }
+
+    try {
+        cubature_qmc([](const Vector&) { return 1.0; }, Vector(17, 0.0), Vector(17, 1.0), 100);
+        FAIL("Cubature QMC d>16 - expected throw");
+    }
+    catch (const std::invalid_argument&) { PASS("Cubature QMC d>16"); }
+
 
     std::cout << "\nKoniec testow\n";
 }